@@ -0,0 +1,222 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  editenv - Environment Variable Editor C++ Class Template
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef EDITENV_BASIC_ENV_VAR
+#define EDITENV_BASIC_ENV_VAR
+
+#include <limits>
+#include <string>
+
+#include "editenvTypes.hpp"
+
+// This class template provides the same interface as EnvVar, but with the
+// scope and the storage backend fixed at compile time. No scope is looked up
+// at run time, so calls can be inlined straight into the backend.
+//
+// A backend is a class providing the following static member function
+// templates, each instantiated for the scope being accessed:
+//
+//     // Reads the named variable. Returns false if it does not exist.
+//     template <env_scope Scope>
+//     static bool read (std::string const &name, std::string &value);
+//
+//     // Creates or replaces the named variable.
+//     template <env_scope Scope>
+//     static void write (std::string const &name, std::string const &value);
+//
+//     // Deletes the named variable.
+//     template <env_scope Scope>
+//     static void remove (std::string const &name);
+//
+//     // Applies an edit to the named variable's value and writes the result,
+//     // without other editors changing the variable in between (as far as
+//     // the storage allows). The value holds the value last read on entry,
+//     // and receives the new value. Edit is any class with a member function
+//     // void apply (std::string &value).
+//     template <env_scope Scope, class Edit>
+//     static void update (std::string const &name,
+//                         Edit              &edit,
+//                         std::string       &value);
+//
+//     // Notifies interested parties that the named variable changed.
+//     template <env_scope Scope>
+//     static void notify (std::string const &name);
+//
+// See RegistryBackend.hpp and MemoryBackend.hpp for the available backends.
+template <editenv::env_scope Scope, class Backend>
+class editenv::BasicEnvVar
+{
+    // Only the user and system scopes can be accessed.
+    typedef char ScopeMustBeValid_ [(es_invalid != Scope) ? 1 : -1];
+
+public:
+    // Constructs an environment variable object with the given name. Merely
+    // constructing an object does not create a corresponding variable in the
+    // environment. To actually create the environment variable (assuming it
+    // does not already exist), use BasicEnvVar::set.
+    //
+    // name [in]     The environment variable's name.
+    explicit BasicEnvVar (std::string const &name)
+        : name_(name)
+    {
+        if (!Backend::template read<Scope>(name_, value_)) {
+            // This environment variable doesn't exist.
+            value_ = "";
+        }
+    }
+
+    // Removes all matching instance of the specified text from the environment
+    // variable's value. Backends that can (see Backend::update) cut the text
+    // from the value currently stored, which may have been changed since this
+    // object read it.
+    //
+    // text [in]    Text to cut from the variable's value.
+    //
+    // Return Value: Returns the number of matching instances that were cut.
+    unsigned int cut (std::string const &text)
+    {
+        Cut_ edit(text);
+
+        Backend::template update<Scope, Cut_>(name_, edit, value_);
+        Backend::template notify<Scope>(name_);
+
+        return edit.count();
+    }
+
+    // Appends the specified text to the variable's current value. Backends that
+    // can (see Backend::update) append the text to the value currently stored,
+    // which may have been changed since this object read it.
+    //
+    // text [in]    Text to append to the variable's value.
+    //
+    // Return Value: Nothing.
+    void paste (std::string const &text)
+    {
+        Paste_ edit(text);
+
+        Backend::template update<Scope, Paste_>(name_, edit, value_);
+        Backend::template notify<Scope>(name_);
+    }
+
+    // Assigns the specified text as the variable's value. Creates the variable
+    // if it does not yet exist in the environment.
+    //
+    // text [in]    Text to assign as the variable's value.
+    //
+    // Return Value: Nothing.
+    void set (std::string const &text)
+    {
+        value_ = text;
+
+        Backend::template write<Scope>(name_, value_);
+        Backend::template notify<Scope>(name_);
+    }
+
+    // Deletes the variable from the environment.
+    //
+    // Return Value: Nothing.
+    void unset ()
+    {
+        value_ = "";
+
+        Backend::template remove<Scope>(name_);
+        Backend::template notify<Scope>(name_);
+    }
+
+    // Retrieves the variable's current value.
+    //
+    // Return Value: A copy of the variable's value. Modifying the returned
+    //               string has no effect on the variable's value.
+    std::string value () const
+    {
+        return value_;
+    }
+
+private:
+    // Private class for the edit made by cut.
+    class Cut_
+    {
+    public:
+        explicit Cut_ (std::string const &text)
+            : count_(0),
+              text_(text)
+        {
+        }
+
+        void apply (std::string &value)
+        {
+            size_t const sizeMax = std::numeric_limits<size_t>::max();
+
+            size_t length = text_.length();
+            size_t pos;
+
+            // Every string contains the empty string, so there is nothing to
+            // cut.
+            if (text_.empty()) {
+                return;
+            }
+
+            // Replace every instance of text with the empty string.
+            pos = value.find(text_);
+            while (sizeMax != pos) {
+                ++count_;
+                value.replace(pos, length, "");
+                pos = value.find(text_);
+            }
+        }
+
+        // Retrieves the number of instances cut.
+        unsigned int count () const
+        {
+            return count_;
+        }
+
+    private:
+        unsigned int       count_; // Number of instances cut.
+        std::string const &text_;  // Text to cut.
+    };
+
+    // Private class for the edit made by paste.
+    class Paste_
+    {
+    public:
+        explicit Paste_ (std::string const &text)
+            : text_(text)
+        {
+        }
+
+        void apply (std::string &value)
+        {
+            value += text_;
+        }
+
+    private:
+        std::string const &text_; // Text to append.
+    };
+
+    // Private Data:
+    std::string name_;  // The environment variable's name.
+    std::string value_; // The environment variable's value.
+};
+
+#endif // EDITENV_BASIC_ENV_VAR
\ No newline at end of file
@@ -0,0 +1,805 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  editenv - Environment File Storage Backend Implementation
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pwd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "EnvFileBackend.hpp"
+
+using namespace editenv;
+
+// Global Constants
+static char const *nameChars          = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                        "abcdefghijklmnopqrstuvwxyz"
+                                        "0123456789_";
+static char const *systemEnvDirectory = "/etc";
+static char const *systemEnvFile      = "environment";
+static char const *systemLockFile     = ".environment.lock";
+static char const *userEnvDirectory   = "environment.d";
+static char const *userEnvFile        = "50-editenv.conf";
+static char const *userEnvSuffix      = ".conf";
+static char const *userLockFile       = ".editenv.lock";
+
+// Characters that can appear in an environment.d value without quoting.
+static char const *userPlainChars     = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                        "abcdefghijklmnopqrstuvwxyz"
+                                        "0123456789_%+,-./:=@^~";
+
+// Global Variables
+static EnvFileStore *batches [es_user + 1]; // Open batch for each scope.
+
+// The environment files of one scope, parsed into memory and indexed by
+// variable name. Holds the scope's lock for as long as it exists: exclusively
+// if it was opened for writing, and otherwise shared.
+class editenv::EnvFileStore
+{
+public:
+    EnvFileStore (env_scope scope, bool writing);
+    ~EnvFileStore ();
+
+    bool get (std::string const &name, std::string &value) const;
+    bool set (std::string const &name, std::string const &value);
+    void unset (std::string const &name);
+    bool commit ();
+
+private:
+    // A line of a file. Lines that define a variable also hold its value.
+    struct Line_
+    {
+        bool        exported; // Whether the definition starts with "export".
+        bool        removed;  // Whether the line has been deleted.
+        std::string text;     // The line, as it appears in the file.
+        std::string value;    // The value defined by the line (if any).
+    };
+
+    // A file and its lines.
+    struct File_
+    {
+        bool               changed; // Whether the file must be rewritten.
+        std::vector<Line_> lines;
+        std::string        path;
+    };
+
+    // The position of a variable definition.
+    struct Location_
+    {
+        size_t file;
+        size_t line;
+    };
+
+    // Maps each variable name to its definitions, in the order they are read
+    // (the last definition is the one in effect).
+    typedef std::map<std::string, std::vector<Location_> > Index_;
+
+    EnvFileStore (EnvFileStore const &other);
+    EnvFileStore & operator = (EnvFileStore const &other);
+
+    bool load_ (std::string const &path);
+    static bool write_ (File_ const &file);
+
+    bool               broken_;      // Whether the files can't be written.
+    size_t             defaultFile_; // File that new variables are added to.
+    std::string        directory_;   // Directory holding the files.
+    std::vector<File_> files_;       // The files, in the order they are read.
+    Index_             index_;       // Definitions of each variable.
+    int                lock_;        // Locked descriptor of the lock file.
+    bool               rejected_;    // Whether an edit has been rejected.
+    env_scope          scope_;       // Scope of the files.
+};
+
+// Determines the user's configuration directory.
+static std::string configHome ()
+{
+    char const    *home = getenv("XDG_CONFIG_HOME");
+    struct passwd *user;
+
+    if ((NULL != home) && ('\0' != home[0])) {
+        return home;
+    }
+    home = getenv("HOME");
+    if ((NULL == home) || ('\0' == home[0])) {
+        user = getpwuid(getuid());
+        home = (NULL == user) ? "" : user->pw_dir;
+    }
+
+    return std::string(home) + "/.config";
+}
+
+// Takes the lock that serializes the editors of a scope's files. The lock is
+// on a lock file of its own rather than on the files, since committing
+// replaces the files with new ones. Writers create the lock file if necessary
+// and lock it exclusively; a writer that can't take the lock (for instance,
+// because the lock file belongs to another user) must not write. Readers lock
+// it shared, but only if they can open it. The lock file can only be opened by
+// its owner, so other users can't hold up its owner's editors by holding the
+// lock. Reading without the lock is still safe, since the files are only ever
+// replaced whole, by renaming. Returns the locked descriptor, or -1 if the
+// lock wasn't taken.
+static int lockScope (std::string const &path, bool exclusive)
+{
+    int descriptor;
+
+    if (exclusive) {
+        descriptor = open(path.c_str(), O_RDWR | O_CREAT, 0600);
+    } else {
+        descriptor = open(path.c_str(), O_RDONLY);
+    }
+    if (-1 == descriptor) {
+        return -1;
+    }
+    while (-1 == flock(descriptor, exclusive ? LOCK_EX : LOCK_SH)) {
+        if (EINTR != errno) {
+            close(descriptor);
+            return -1;
+        }
+    }
+
+    return descriptor;
+}
+
+// Determines whether a string is a valid variable name.
+static bool validName (std::string const &name)
+{
+    size_t const sizeMax = std::numeric_limits<size_t>::max();
+
+    return !name.empty() &&
+           (sizeMax == name.find_first_not_of(nameChars)) &&
+           (('0' > name[0]) || ('9' < name[0]));
+}
+
+// Reads a value from /etc/environment the way pam_env does: the value ends at
+// the first '#', and a pair of matching quotes around it is removed. Nothing
+// is unescaped.
+static std::string systemValue (std::string const &text)
+{
+    size_t const sizeMax = std::numeric_limits<size_t>::max();
+
+    size_t      end;
+    std::string value = text.substr(0, text.find('#'));
+
+    end = value.find_last_not_of(" \t\r");
+    value.erase((sizeMax == end) ? 0 : end + 1);
+    if ((value.length() >= 2) &&
+        (('"' == value[0]) || ('\'' == value[0])) &&
+        (value[0] == value[value.length() - 1])) {
+        value = value.substr(1, value.length() - 2);
+    }
+
+    return value;
+}
+
+// Reads a value from an environment.d file the way systemd does. Whitespace
+// around the value is ignored. Outside quotes, a backslash escapes the next
+// character. Within single quotes, nothing is escaped. Within double quotes, a
+// backslash escapes '"', '\', '`' and '$', and is otherwise kept. Quoted and
+// unquoted parts may be joined together. References to other variables ($NAME
+// and ${NAME}) and "$$" (a literal '$') are left as they are, for systemd to
+// expand when it reads the file.
+static std::string userValue (std::string const &text)
+{
+    size_t const sizeMax = std::numeric_limits<size_t>::max();
+
+    enum State {
+        pre,    // Before a part of the value (whitespace is skipped)
+        plain,  // In an unquoted part
+        single, // In a single quoted part
+        double_ // In a double quoted part
+    };
+
+    char        c;
+    size_t      plainEnd = 0; // Length of value, less trailing whitespace.
+    State       state = pre;
+    std::string value;
+
+    for (size_t i = 0; i < text.length(); ++i) {
+        c = text[i];
+        switch (state) {
+        case pre:
+        case plain:
+            if ('\r' == c) {
+                break;
+            }
+            if ((pre == state) && (('\'' == c) || ('"' == c))) {
+                state = ('\'' == c) ? single : double_;
+                break;
+            }
+            if ((pre == state) && ((' ' == c) || ('\t' == c))) {
+                break;
+            }
+            state = plain;
+            if (('\\' == c) && (i + 1 < text.length())) {
+                c = text[++i];
+            } else if ((' ' == c) || ('\t' == c)) {
+                value += c;
+                break;
+            }
+            value += c;
+            plainEnd = value.length();
+            break;
+
+        case single:
+            if ('\'' == c) {
+                state = pre;
+                plainEnd = value.length();
+            } else {
+                value += c;
+            }
+            break;
+
+        case double_:
+            if ('"' == c) {
+                state = pre;
+                plainEnd = value.length();
+            } else if (('\\' == c) && (i + 1 < text.length())) {
+                c = text[++i];
+                if (sizeMax == std::string("\"\\`$").find(c)) {
+                    value += '\\';
+                }
+                value += c;
+            } else {
+                value += c;
+            }
+            break;
+        }
+    }
+    if (plain == state) {
+        value.erase(plainEnd);
+    }
+
+    return value;
+}
+
+// Parses a line of an environment file. Returns false if the line doesn't
+// define a variable (e.g. it is blank or a comment).
+static bool parseLine (env_scope          scope,
+                       std::string const &text,
+                       bool              &exported,
+                       std::string       &name,
+                       std::string       &value)
+{
+    size_t const sizeMax = std::numeric_limits<size_t>::max();
+
+    size_t end;
+    size_t equals;
+    size_t start;
+
+    start = text.find_first_not_of(" \t");
+    if ((sizeMax == start) ||
+        ('#' == text[start]) ||
+        ((es_user == scope) && (';' == text[start]))) {
+        return false;
+    }
+
+    // Definitions may be written as shell commands.
+    exported = (0 == text.compare(start, 7, "export "));
+    if (exported) {
+        start = text.find_first_not_of(" \t", start + 7);
+        if (sizeMax == start) {
+            return false;
+        }
+    }
+
+    equals = text.find('=', start);
+    if ((sizeMax == equals) || (start == equals)) {
+        return false;
+    }
+    end = text.find_last_not_of(" \t", equals - 1);
+    name = text.substr(start, end - start + 1);
+    if (!validName(name)) {
+        return false;
+    }
+
+    if (es_system == scope) {
+        value = systemValue(text.substr(equals + 1));
+    } else {
+        value = userValue(text.substr(equals + 1));
+    }
+
+    return true;
+}
+
+// Formats a variable definition so that the program reading the file gets the
+// value back exactly. Returns false if the value can't be represented:
+//
+//  - environment.d: values that need it are double quoted, with '"', '\' and
+//    '`' escaped. '$' is written as it is, so references to other variables
+//    still work (and "$$" still stands for a literal '$'). Line breaks can't
+//    be represented.
+//  - /etc/environment: pam_env unescapes nothing, so values containing
+//    quotes, '#' or line breaks can't be represented. Values containing
+//    whitespace or backslashes are double quoted.
+static bool formatLine (env_scope          scope,
+                        std::string const &name,
+                        std::string const &value,
+                        bool               exported,
+                        std::string       &text)
+{
+    size_t const sizeMax = std::numeric_limits<size_t>::max();
+
+    std::string quoted;
+
+    if (!validName(name) || (sizeMax != value.find_first_of("\n\r"))) {
+        return false;
+    }
+    text = exported ? "export " : "";
+    text += name + "=";
+
+    if (es_system == scope) {
+        if (sizeMax != value.find_first_of("#\"'")) {
+            return false;
+        }
+        if (sizeMax == value.find_first_of(" \t\\")) {
+            text += value;
+        } else {
+            text += "\"" + value + "\"";
+        }
+        return true;
+    }
+
+    if (sizeMax == value.find_first_not_of(userPlainChars)) {
+        text += value;
+        return true;
+    }
+    for (size_t i = 0; i < value.length(); ++i) {
+        if (('"' == value[i]) || ('\\' == value[i]) || ('`' == value[i])) {
+            quoted += '\\';
+        }
+        quoted += value[i];
+    }
+    text += "\"" + quoted + "\"";
+
+    return true;
+}
+
+EnvFileStore::EnvFileStore (env_scope scope, bool writing)
+    : broken_(false),
+      defaultFile_(0),
+      lock_(-1),
+      rejected_(false),
+      scope_(scope)
+{
+    DIR                      *directory;
+    struct dirent            *entry;
+    std::string               fileName;
+    std::vector<std::string>  fileNames;
+    std::string               home;
+    size_t                    suffixLength = std::string(userEnvSuffix).length();
+
+    switch (scope) {
+    case es_system:
+        directory_ = systemEnvDirectory;
+        lock_ = lockScope(directory_ + "/" + systemLockFile, writing);
+        fileNames.push_back(systemEnvFile);
+        break;
+
+    case es_user:
+        // Only writers create the directory.
+        home = configHome();
+        directory_ = home + "/" + userEnvDirectory;
+        if (writing) {
+            mkdir(home.c_str(), 0755);
+            mkdir(directory_.c_str(), 0755);
+        }
+
+        // List the files only once the lock is held, so that a file added by
+        // another editor can't be missed.
+        lock_ = lockScope(directory_ + "/" + userLockFile, writing);
+        fileNames.push_back(userEnvFile);
+        directory = opendir(directory_.c_str());
+        if ((NULL == directory) && (ENOENT != errno)) {
+            broken_ = true;
+        }
+        while ((NULL != directory) && (NULL != (entry = readdir(directory)))) {
+            fileName = entry->d_name;
+            if ((fileName.length() > suffixLength) &&
+                ('.' != fileName[0]) &&
+                (0 == fileName.compare(fileName.length() - suffixLength,
+                                       suffixLength,
+                                       userEnvSuffix)) &&
+                (fileName != userEnvFile)) {
+                fileNames.push_back(fileName);
+            }
+        }
+        if (NULL != directory) {
+            closedir(directory);
+        }
+        std::sort(fileNames.begin(), fileNames.end());
+        break;
+
+    default:
+        assert(false);
+        return;
+    }
+
+    // Writing without the lock, or after failing to read a file (which
+    // would then be overwritten with only the edits), could lose changes.
+    if (writing && (-1 == lock_)) {
+        broken_ = true;
+    }
+    for (size_t i = 0; i < fileNames.size(); ++i) {
+        if (fileNames[i] == userEnvFile) {
+            defaultFile_ = i;
+        }
+        if (!load_(directory_ + "/" + fileNames[i])) {
+            broken_ = true;
+        }
+    }
+}
+
+EnvFileStore::~EnvFileStore ()
+{
+    if (-1 != lock_) {
+        close(lock_);
+    }
+}
+
+bool EnvFileStore::get (std::string const &name, std::string &value) const
+{
+    Index_::const_iterator found = index_.find(name);
+
+    if ((index_.end() == found) || files_.empty()) {
+        return false;
+    }
+    Location_ const &last = found->second.back();
+    value = files_[last.file].lines[last.line].value;
+
+    return true;
+}
+
+bool EnvFileStore::set (std::string const &name, std::string const &value)
+{
+    Index_::iterator found = index_.find(name);
+    Line_            line;
+    Location_        location;
+
+    if (files_.empty()) {
+        return false;
+    }
+
+    if (index_.end() != found) {
+        // Edit the definition that is in effect.
+        Location_ const &last = found->second.back();
+        Line_           &edited = files_[last.file].lines[last.line];
+
+        if (!formatLine(scope_, name, value, edited.exported, line.text)) {
+            rejected_ = true;
+            return false;
+        }
+        edited.text = line.text;
+        edited.value = value;
+        files_[last.file].changed = true;
+        return true;
+    }
+
+    line.exported = false;
+    line.removed = false;
+    if (!formatLine(scope_, name, value, line.exported, line.text)) {
+        rejected_ = true;
+        return false;
+    }
+    line.value = value;
+    location.file = defaultFile_;
+    location.line = files_[defaultFile_].lines.size();
+    files_[defaultFile_].lines.push_back(line);
+    files_[defaultFile_].changed = true;
+    index_[name].push_back(location);
+
+    return true;
+}
+
+void EnvFileStore::unset (std::string const &name)
+{
+    Index_::iterator found = index_.find(name);
+
+    if (index_.end() == found) {
+        return;
+    }
+
+    // Remove every definition, so that an earlier one doesn't take effect.
+    for (size_t i = 0; i < found->second.size(); ++i) {
+        Location_ const &location = found->second[i];
+
+        files_[location.file].lines[location.line].removed = true;
+        files_[location.file].changed = true;
+    }
+    index_.erase(found);
+}
+
+bool EnvFileStore::commit ()
+{
+    bool result = !rejected_;
+
+    rejected_ = false;
+    if (broken_) {
+        return false;
+    }
+    for (size_t i = 0; i < files_.size(); ++i) {
+        if (!files_[i].changed) {
+            continue;
+        }
+        if (write_(files_[i])) {
+            files_[i].changed = false;
+        } else {
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+bool EnvFileStore::load_ (std::string const &path)
+{
+    size_t const sizeMax = std::numeric_limits<size_t>::max();
+
+    char        buffer [4096];
+    std::string contents;
+    int         descriptor;
+    size_t      end;
+    File_       file;
+    Line_       line;
+    Location_   location;
+    std::string name;
+    bool        result = true;
+    ssize_t     size;
+    size_t      start = 0;
+
+    file.changed = false;
+    file.path = path;
+    line.removed = false;
+    location.file = files_.size();
+
+    // A file that doesn't exist is empty. Any other failure to read it is
+    // reported.
+    descriptor = open(path.c_str(), O_RDONLY);
+    if (-1 == descriptor) {
+        result = (ENOENT == errno);
+    }
+    while (-1 != descriptor) {
+        size = ::read(descriptor, buffer, sizeof(buffer));
+        if (0 < size) {
+            contents.append(buffer, size);
+        } else if ((0 == size) || (EINTR != errno)) {
+            result = (0 == size);
+            close(descriptor);
+            descriptor = -1;
+        }
+    }
+
+    while (start < contents.length()) {
+        end = contents.find('\n', start);
+        if (sizeMax == end) {
+            end = contents.length();
+        }
+        line.text = contents.substr(start, end - start);
+        start = end + 1;
+        if (parseLine(scope_, line.text, line.exported, name, line.value)) {
+            location.line = file.lines.size();
+            index_[name].push_back(location);
+        } else {
+            line.exported = false;
+            line.value = "";
+        }
+        file.lines.push_back(line);
+    }
+    files_.push_back(file);
+
+    return result;
+}
+
+bool EnvFileStore::write_ (File_ const &file)
+{
+    std::string  contents;
+    int          descriptor;
+    std::string  directory;
+    mode_t       mode = 0644;
+    std::string  path = file.path;
+    char        *resolved;
+    ssize_t      size;
+    struct stat  status;
+    bool         synced;
+    std::string  temporary;
+    size_t       written = 0;
+
+    for (size_t i = 0; i < file.lines.size(); ++i) {
+        if (!file.lines[i].removed) {
+            contents += file.lines[i].text;
+            contents += '\n';
+        }
+    }
+
+    // Files are often symbolic links (for instance, to files kept by a dotfile
+    // manager), so write to the file the link refers to rather than replacing
+    // the link. A link to a file that doesn't exist is left alone.
+    resolved = realpath(file.path.c_str(), NULL);
+    if (NULL != resolved) {
+        path = resolved;
+        free(resolved);
+    } else if ((ENOENT != errno) || (0 == lstat(file.path.c_str(), &status))) {
+        return false;
+    }
+    directory = path.substr(0, path.rfind('/'));
+
+    // Write the new contents to a temporary file in the same directory, so
+    // that it can be renamed over the original.
+    temporary = directory + "/." + path.substr(directory.length() + 1) +
+                ".XXXXXX";
+    descriptor = mkstemp(&temporary[0]);
+    if (-1 == descriptor) {
+        return false;
+    }
+    while (written < contents.length()) {
+        size = ::write(descriptor,
+                       contents.data() + written,
+                       contents.length() - written);
+        if (-1 == size) {
+            if (EINTR == errno) {
+                continue;
+            }
+            break;
+        }
+        written += size;
+    }
+
+    // Give the new file the original's permissions and owner.
+    if (0 == stat(path.c_str(), &status)) {
+        mode = status.st_mode & 07777;
+        if (0 != fchown(descriptor, status.st_uid, status.st_gid)) {
+            // Only the superuser can give files away, so keep ours.
+        }
+    }
+    fchmod(descriptor, mode);
+
+    // Close the descriptor whether or not the writes succeeded.
+    synced = (written == contents.length()) && (0 == fsync(descriptor));
+    if ((0 != close(descriptor)) ||
+        !synced ||
+        (0 != rename(temporary.c_str(), path.c_str()))) {
+        unlink(temporary.c_str());
+        return false;
+    }
+
+    // Make the rename itself durable.
+    descriptor = open(directory.c_str(), O_RDONLY);
+    if (-1 != descriptor) {
+        fsync(descriptor);
+        close(descriptor);
+    }
+
+    return true;
+}
+
+template <env_scope Scope>
+bool EnvFileBackend::read (std::string const &name, std::string &value)
+{
+    if (NULL != batches[Scope]) {
+        return batches[Scope]->get(name, value);
+    }
+
+    return EnvFileStore(Scope, false).get(name, value);
+}
+
+template <env_scope Scope>
+void EnvFileBackend::write (std::string const &name, std::string const &value)
+{
+    if (NULL != batches[Scope]) {
+        batches[Scope]->set(name, value);
+        return;
+    }
+
+    EnvFileStore store(Scope, true);
+
+    if (store.set(name, value)) {
+        store.commit();
+    }
+}
+
+template <env_scope Scope>
+void EnvFileBackend::remove (std::string const &name)
+{
+    if (NULL != batches[Scope]) {
+        batches[Scope]->unset(name);
+        return;
+    }
+
+    EnvFileStore store(Scope, true);
+
+    store.unset(name);
+    store.commit();
+}
+
+EnvFileBackend::Update_::Update_ (env_scope scope)
+    : batched_(NULL != batches[scope]),
+      store_(batches[scope])
+{
+    // Outside a batch, read and write the variable under a single exclusive
+    // lock, so that no other editor's change is lost in between.
+    if (!batched_) {
+        store_ = new EnvFileStore(scope, true);
+    }
+}
+
+EnvFileBackend::Update_::~Update_ ()
+{
+    if (!batched_) {
+        delete store_;
+    }
+}
+
+void EnvFileBackend::Update_::read (std::string const &name, std::string &value)
+{
+    if (!store_->get(name, value)) {
+        value = "";
+    }
+}
+
+void EnvFileBackend::Update_::write (std::string const &name,
+                                     std::string const &value)
+{
+    if (store_->set(name, value) && !batched_) {
+        store_->commit();
+    }
+}
+
+EnvFileBatch::EnvFileBatch (env_scope scope)
+    : scope_(scope),
+      store_(new EnvFileStore(scope, true))
+{
+    assert(NULL == batches[scope_]);
+    batches[scope_] = store_;
+}
+
+EnvFileBatch::~EnvFileBatch ()
+{
+    store_->commit();
+    batches[scope_] = NULL;
+    delete store_;
+}
+
+bool EnvFileBatch::commit ()
+{
+    return store_->commit();
+}
+
+// Explicit instantiations for the supported scopes.
+template bool EnvFileBackend::read<es_system> (std::string const &,
+                                               std::string &);
+template bool EnvFileBackend::read<es_user> (std::string const &,
+                                             std::string &);
+template void EnvFileBackend::write<es_system> (std::string const &,
+                                                std::string const &);
+template void EnvFileBackend::write<es_user> (std::string const &,
+                                              std::string const &);
+template void EnvFileBackend::remove<es_system> (std::string const &);
+template void EnvFileBackend::remove<es_user> (std::string const &);
\ No newline at end of file
@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  editenv - Environment File Storage Backend Header
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef EDITENV_ENV_FILE_BACKEND
+#define EDITENV_ENV_FILE_BACKEND
+
+#include <string>
+
+#include "editenvTypes.hpp"
+
+// This class is the BasicEnvVar backend for the persistent environment files
+// used on Linux. System variables live in /etc/environment, and user variables
+// in the *.conf files of the user's environment.d directory
+// ($XDG_CONFIG_HOME/environment.d, or ~/.config/environment.d). Where a user
+// variable is defined in more than one file, the definition in the last file
+// (in lexical order) is the one that is read and edited. New user variables
+// are added to 50-editenv.conf.
+//
+// Comments, blank lines, "export" prefixes and the order of the definitions
+// are kept as they are. Values are read and written the way the programs that
+// use the files read them:
+//
+//  - environment.d (see environment.d(5)): values other than plain words are
+//    written in double quotes, with '"', '\' and '`' escaped. References to
+//    other variables ($NAME or ${NAME}) are read and written as they are, so
+//    systemd still expands them; for example, appending ":/opt/bin" to
+//    "$HOME/bin:$PATH" gives "$HOME/bin:$PATH:/opt/bin". To store a literal
+//    '$', write "$$".
+//  - /etc/environment (see pam_env): values containing whitespace or '\'
+//    are written in double quotes. pam_env has no escapes, so values
+//    containing quotes or '#' are rejected and left unwritten.
+//
+// Values containing line breaks are rejected in both scopes.
+//
+// Each read, write or remove made outside of an EnvFileBatch reads, edits and
+// rewrites the scope's files on its own. A cut or paste made outside of a
+// batch reads and rewrites the files under a single lock (see update). To make
+// many edits with a single rewrite, make them while an EnvFileBatch for the
+// scope exists. Edits are only written while the scope's lock is held (see
+// EnvFileBatch); an edit that can't take the lock is not made.
+//
+// Example:
+//
+//     {
+//         EnvFileBatch batch(es_user);
+//         BasicEnvVar<es_user, EnvFileBackend> editor("EDITOR");
+//         BasicEnvVar<es_user, EnvFileBackend> pager("PAGER");
+//
+//         editor.set("vi");
+//         pager.unset();
+//     } // Both edits are written here.
+//
+// Note: This backend is only available on POSIX systems. EnvFileBackend.cpp
+//       is not part of the Windows DLL project.
+class editenv::EnvFileBackend
+{
+public:
+    template <env_scope Scope>
+    static bool read (std::string const &name, std::string &value);
+
+    template <env_scope Scope>
+    static void write (std::string const &name, std::string const &value);
+
+    template <env_scope Scope>
+    static void remove (std::string const &name);
+
+    // Reads the named variable, applies an edit to its value and writes the
+    // result back. Outside of a batch, the scope's files are kept locked from
+    // the read until the write, so that no other editor's change is lost in
+    // between. Edit is any class with a member function
+    // void apply (std::string &value).
+    //
+    // name [in]     The environment variable's name.
+    //
+    // edit [in]     The edit to apply.
+    //
+    // value [out]   Receives the new value.
+    //
+    // Return Value: Nothing.
+    template <env_scope Scope, class Edit>
+    static void update (std::string const &name,
+                        Edit              &edit,
+                        std::string       &value)
+    {
+        Update_ update(Scope);
+
+        update.read(name, value);
+        edit.apply(value);
+        update.write(name, value);
+    }
+
+    // Does nothing. Programs that use these files only read them when they
+    // start (for instance, systemd reads environment.d when the user's service
+    // manager starts).
+    template <env_scope Scope>
+    static void notify (std::string const & /* name */)
+    {
+    }
+
+private:
+    // Private class that holds a scope's files for the duration of an update:
+    // the open batch's files, or else the files read under an exclusive lock
+    // that is held until the update is destroyed.
+    class Update_
+    {
+    public:
+        explicit Update_ (env_scope scope);
+        ~Update_ ();
+
+        void read (std::string const &name, std::string &value);
+        void write (std::string const &name, std::string const &value);
+
+    private:
+        Update_ (Update_ const &other);
+        Update_ & operator = (Update_ const &other);
+
+        bool          batched_; // Whether the files belong to the batch.
+        EnvFileStore *store_;   // The scope's files.
+    };
+};
+
+// This class groups edits to one scope's environment files into a batch. When
+// the batch is created, it takes an exclusive advisory lock (flock) on the
+// scope's lock file, so that other editors using this library wait until the
+// batch is finished, and then reads the files. The lock files are
+// /etc/.environment.lock and environment.d/.editenv.lock. They are created
+// readable only by their owner, so other users can neither hold up an editor
+// nor take the lock themselves; readers that can open a lock file take a
+// shared lock on it, and the others read without one. If the batch can't take
+// the lock, or can't read one of the files (other than because it doesn't
+// exist), nothing is written and committing fails. Files that are symbolic
+// links are written through the link.
+//
+// Until the batch is committed, every EnvFileBackend read, write and remove for
+// the scope is made in memory. Committing writes each changed file once, to a
+// temporary file that is synced and then renamed over the original, so readers
+// of a file see either all of the batch's edits to it or none of them.
+//
+// Note: A batch applies to every thread in the process. Only one batch per
+//       scope can exist at a time.
+class editenv::EnvFileBatch
+{
+public:
+    // Starts a batch of edits to a scope's environment files.
+    //
+    // scope [in]    Environment scope (user or system environment).
+    explicit EnvFileBatch (env_scope scope);
+
+    // Commits the batch (unless it has already been committed) and releases
+    // the lock.
+    ~EnvFileBatch ();
+
+    // Writes the files changed by the batch so far. Further edits may be made
+    // afterwards, and are written by the next commit.
+    //
+    // Return Value: Returns true if every changed file was written and no
+    //               value has been rejected since the last commit, or false
+    //               if the files could not be locked or read.
+    bool commit ();
+
+private:
+    // Batches hold a lock, so they cannot be copied.
+    EnvFileBatch (EnvFileBatch const &other);
+    EnvFileBatch & operator = (EnvFileBatch const &other);
+
+    // Private Data:
+    env_scope     scope_; // Scope of the batch.
+    EnvFileStore *store_; // The scope's files, as read when the batch began.
+};
+
+#endif // EDITENV_ENV_FILE_BACKEND
\ No newline at end of file
@@ -0,0 +1,783 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  editenv - Environment Change Subscription C++ Class Implementation
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <sstream>
+#include <vector>
+#include <windows.h>
+#include <sddl.h>
+#else
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sstream>
+#include <strings.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "EnvSubscription.hpp"
+
+using namespace editenv;
+
+// Global Constants
+static unsigned long const ringSize      = 256; // changes kept in the ring
+static unsigned int const  subscriberMax = 128; // concurrent subscribers
+static unsigned long const lockTimeout   = 100; // milliseconds
+#ifdef _WIN32
+static char const         *eventPrefix   = "Local\\editenv.changes.";
+static char const         *lockName      = "Local\\editenv.changes.lock";
+static char const         *mappingName   = "Local\\editenv.changes";
+#else
+static char const         *segmentPrefix = "/editenv.changes.";
+#endif
+
+// Security given to the shared objects, around the SID of the user who creates
+// them. Only that user, the local system and administrators get access, so
+// other users in the session can neither forge changes nor hold the lock. The
+// objects are labeled medium integrity, so that the objects created by an
+// elevated subscriber can still be opened by publishers running at medium
+// integrity (the default label would be high integrity).
+#ifdef _WIN32
+static char const *objectSecurityBegin = "D:(A;;GA;;;SY)(A;;GA;;;BA)(A;;GA;;;";
+static char const *objectSecurityEnd   = ")S:(ML;;NW;;;ME)";
+#endif
+
+// A change recorded in the ring buffer.
+struct SharedChange
+{
+    env_scope     scope;
+    unsigned long version;
+    char          name [envNameMax];
+};
+
+// A registered subscriber. On Windows, the subscriber's event is named after
+// its slot. Elsewhere, the subscriber sleeps on a futex in its slot.
+struct SharedSubscriber
+{
+    long      active;
+    env_scope scope;
+    char      name [envNameMax];
+#ifndef _WIN32
+    pid_t     process; // Process that owns the slot.
+    int       wake;    // Futex word, bumped for each matching change.
+#endif
+};
+
+// Layout of the shared segment. The segment is zero-filled when it is first
+// created, which leaves every subscriber slot inactive and the version at 0.
+struct SharedSegment
+{
+#ifndef _WIN32
+    int              ready;   // Nonzero once the mutex is initialized.
+    pthread_mutex_t  lock;    // Mutex protecting the rest of the segment.
+#endif
+    unsigned long    version; // Version of the most recent change.
+    SharedSubscriber subscribers [subscriberMax];
+    SharedChange     changes [ringSize];
+};
+
+#ifdef _WIN32
+// Retrieves the SID of the user the process runs as, in string form, or the
+// empty string if it can't be retrieved.
+static std::string userSid ()
+{
+    std::vector<BYTE> buffer;
+    DWORD             size = 0;
+    char             *sid;
+    std::string       result;
+    HANDLE            token;
+
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token)) {
+        return result;
+    }
+    GetTokenInformation(token, TokenUser, NULL, 0, &size);
+    if (0 != size) {
+        buffer.resize(size);
+        if (GetTokenInformation(token, TokenUser, &buffer[0], size, &size) &&
+            ConvertSidToStringSid(
+                reinterpret_cast<TOKEN_USER *>(&buffer[0])->User.Sid, &sid)) {
+            result = sid;
+            LocalFree(sid);
+        }
+    }
+    CloseHandle(token);
+
+    return result;
+}
+
+// Builds the security attributes given to the shared objects. If the security
+// descriptor can't be built (mandatory labels need Windows Vista or later),
+// returns NULL so that the objects get the default security instead, which
+// also gives access only to their creator, the local system and
+// administrators. The descriptor must be freed with LocalFree.
+static SECURITY_ATTRIBUTES * objectAttributes (SECURITY_ATTRIBUTES &attributes)
+{
+    PSECURITY_DESCRIPTOR descriptor;
+    std::string const    sid = userSid();
+
+    if (sid.empty()) {
+        return NULL;
+    }
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptor(
+            (objectSecurityBegin + sid + objectSecurityEnd).c_str(),
+            SDDL_REVISION_1,
+            &descriptor,
+            NULL)) {
+        return NULL;
+    }
+    attributes.nLength = sizeof(attributes);
+    attributes.lpSecurityDescriptor = descriptor;
+    attributes.bInheritHandle = FALSE;
+
+    return &attributes;
+}
+
+// Builds the name of the event belonging to the given subscriber slot.
+static std::string eventName (int slot)
+{
+    std::ostringstream name;
+
+    name << eventPrefix << slot;
+
+    return name.str();
+}
+
+// Acquires the shared segment's mutex, waiting at most lockTimeout
+// milliseconds, so that a process that holds the mutex and hangs can't hang
+// everyone who changes the environment. A mutex abandoned by a process that
+// died while holding it is still acquired, and the segment remains usable
+// since every update leaves it consistent.
+//
+// Return Value: Returns true if the mutex was acquired, or false if the
+//               timeout elapsed first.
+static bool acquire (HANDLE lock)
+{
+    DWORD const result = WaitForSingleObject(lock, lockTimeout);
+
+    return (WAIT_OBJECT_0 == result) || (WAIT_ABANDONED == result);
+}
+
+// Determines whether the process owning a subscriber slot has gone away. A
+// subscriber's event is destroyed along with its process, so a slot whose
+// event no longer exists belongs to a subscriber that exited without
+// unsubscribing. An event that exists but can't be opened (for instance,
+// because access is denied) is taken to be alive.
+static bool abandoned (int slot)
+{
+    HANDLE event = OpenEvent(SYNCHRONIZE, FALSE, eventName(slot).c_str());
+
+    if (NULL == event) {
+        return ERROR_FILE_NOT_FOUND == GetLastError();
+    }
+    CloseHandle(event);
+
+    return false;
+}
+#else
+// Builds the name of the calling user's shared segment.
+static std::string segmentName ()
+{
+    std::ostringstream name;
+
+    name << segmentPrefix << geteuid();
+
+    return name.str();
+}
+
+// Maps the calling user's shared segment, which only that user can open. When
+// subscribing, the segment is created (and its mutex initialized) if it
+// doesn't exist yet. When publishing, NULL is returned if nobody has
+// subscribed yet, since there is nobody to notify. A segment owned by another
+// user (who could read or forge changes) is never used.
+static SharedSegment * openSegment (bool create)
+{
+    int                 descriptor;
+    pthread_mutexattr_t attributes;
+    void               *mapped;
+    SharedSegment      *segment;
+    struct stat         status;
+
+    descriptor = shm_open(segmentName().c_str(),
+                          create ? (O_RDWR | O_CREAT) : O_RDWR,
+                          S_IRUSR | S_IWUSR);
+    if (-1 == descriptor) {
+        return NULL;
+    }
+    if ((create && (0 != ftruncate(descriptor, sizeof(SharedSegment)))) ||
+        (0 != fstat(descriptor, &status)) ||
+        (status.st_uid != geteuid()) ||
+        (status.st_size < static_cast<off_t>(sizeof(SharedSegment)))) {
+        close(descriptor);
+        return NULL;
+    }
+    mapped = mmap(NULL,
+                  sizeof(SharedSegment),
+                  PROT_READ | PROT_WRITE,
+                  MAP_SHARED,
+                  descriptor,
+                  0);
+    if (MAP_FAILED == mapped) {
+        close(descriptor);
+        return NULL;
+    }
+    segment = static_cast<SharedSegment *>(mapped);
+
+    // The first subscriber initializes the mutex, while holding a lock on the
+    // segment itself so that no other subscriber does so at the same time.
+    // The mutex is robust, so that it is not lost along with a process that
+    // dies while holding it.
+    if (create) {
+        flock(descriptor, LOCK_EX);
+        if (!segment->ready) {
+            pthread_mutexattr_init(&attributes);
+            pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+            pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+            pthread_mutex_init(&segment->lock, &attributes);
+            pthread_mutexattr_destroy(&attributes);
+            __sync_synchronize();
+            segment->ready = 1;
+        }
+        flock(descriptor, LOCK_UN);
+    }
+    close(descriptor);
+
+    __sync_synchronize();
+    if (!segment->ready) {
+        munmap(segment, sizeof(SharedSegment));
+        return NULL;
+    }
+
+    return segment;
+}
+
+// Acquires the shared segment's mutex, waiting at most lockTimeout
+// milliseconds, so that a process that holds the mutex and hangs can't hang
+// everyone who changes the environment. A mutex whose owner died while holding
+// it is still acquired, and the segment remains usable since every update
+// leaves it consistent.
+//
+// Return Value: Returns true if the mutex was acquired, or false if the
+//               timeout elapsed first.
+static bool acquire (pthread_mutex_t *lock)
+{
+    struct timespec deadline;
+    int             result;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += static_cast<long>(lockTimeout) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_nsec -= 1000000000;
+        ++deadline.tv_sec;
+    }
+    result = pthread_mutex_timedlock(lock, &deadline);
+    if (EOWNERDEAD == result) {
+        pthread_mutex_consistent(lock);
+        result = 0;
+    }
+
+    return 0 == result;
+}
+
+// Determines whether the process owning a subscriber slot has gone away
+// without unsubscribing.
+static bool abandoned (SharedSubscriber const &subscriber)
+{
+    return (0 != kill(subscriber.process, 0)) && (ESRCH == errno);
+}
+
+// Wakes up a subscriber sleeping on its slot's futex (in any process).
+static void wake (SharedSubscriber *subscriber)
+{
+    __sync_fetch_and_add(&subscriber->wake, 1);
+    syscall(SYS_futex, &subscriber->wake, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+#endif
+
+// Copies a variable name into a fixed size, null terminated buffer,
+// truncating it if necessary.
+static void copyName (char *buffer, std::string const &name)
+{
+    size_t length = name.length();
+
+    if (length > envNameMax - 1) {
+        length = envNameMax - 1;
+    }
+    memcpy(buffer, name.c_str(), length);
+    buffer[length] = '\0';
+}
+
+// Determines whether a change is of interest to a subscriber.
+static bool matches (env_scope   subscriberScope,
+                     char const *subscriberName,
+                     env_scope   scope,
+                     char const *name)
+{
+    if ((es_invalid != subscriberScope) && (subscriberScope != scope)) {
+        return false;
+    }
+
+#ifdef _WIN32
+    return ('\0' == subscriberName[0]) ||
+           (0 == lstrcmpiA(subscriberName, name));
+#else
+    return ('\0' == subscriberName[0]) ||
+           (0 == strcasecmp(subscriberName, name));
+#endif
+}
+
+// Records a change in the ring buffer. The segment must be locked.
+//
+// Return Value: Returns the recorded change.
+static SharedChange const * record (SharedSegment     *segment,
+                                    env_scope          scope,
+                                    std::string const &name)
+{
+    SharedChange *entry;
+
+    ++segment->version;
+    entry = &segment->changes[segment->version % ringSize];
+    entry->scope = scope;
+    entry->version = segment->version;
+    copyName(entry->name, name);
+
+    return entry;
+}
+
+// Retrieves the first change following the given version that is of interest
+// to a subscriber, advancing the version past the changes examined. The
+// segment must be locked.
+//
+// Return Value: Returns true if a change was retrieved (which is an overflow if
+//               the changes following the version have been overwritten), or
+//               false if there is no such change yet.
+static bool next (SharedSegment const *segment,
+                  env_scope            scope,
+                  std::string const   &name,
+                  unsigned long       &version,
+                  env_change          &change)
+{
+    SharedChange const *entry;
+
+    if (segment->version - version > ringSize) {
+        // The changes following the last one examined have already been
+        // overwritten.
+        version = segment->version;
+        change.scope = scope;
+        change.version = version;
+        change.overflow = 1;
+        change.name[0] = '\0';
+        return true;
+    }
+    while (version != segment->version) {
+        ++version;
+        entry = &segment->changes[version % ringSize];
+        if (matches(scope, name.c_str(), entry->scope, entry->name)) {
+            change.scope = entry->scope;
+            change.version = entry->version;
+            change.overflow = 0;
+            memcpy(change.name, entry->name, envNameMax);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+#ifdef _WIN32
+
+EnvSubscription::EnvSubscription (env_scope scope, std::string const &name)
+    : event_(NULL),
+      lock_(NULL),
+      mapping_(NULL),
+      name_(name),
+      scope_(scope),
+      segment_(NULL),
+      slot_(-1),
+      version_(0)
+{
+    SECURITY_ATTRIBUTES  attributes;
+    HANDLE               event;
+    SECURITY_ATTRIBUTES *security;
+    SharedSegment       *segment;
+    SharedSubscriber    *subscriber;
+
+    security = objectAttributes(attributes);
+    lock_ = CreateMutex(security, FALSE, lockName);
+    mapping_ = CreateFileMapping(INVALID_HANDLE_VALUE,
+                                 security,
+                                 PAGE_READWRITE,
+                                 0,
+                                 sizeof(SharedSegment),
+                                 mappingName);
+    if ((NULL == lock_) || (NULL == mapping_)) {
+        if (NULL != security) {
+            LocalFree(security->lpSecurityDescriptor);
+        }
+        return;
+    }
+    segment_ = MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (NULL == segment_) {
+        if (NULL != security) {
+            LocalFree(security->lpSecurityDescriptor);
+        }
+        return;
+    }
+    segment = static_cast<SharedSegment *>(segment_);
+
+    if (!acquire(lock_)) {
+        if (NULL != security) {
+            LocalFree(security->lpSecurityDescriptor);
+        }
+        return;
+    }
+
+    // Free the slots of subscribers that exited without unsubscribing.
+    // Publishers only notice these when a change matches the subscriber, so a
+    // subscriber watching a rarely changed variable would otherwise hold its
+    // slot for the rest of the session.
+    for (int slot = 0; slot < static_cast<int>(subscriberMax); ++slot) {
+        if (segment->subscribers[slot].active && abandoned(slot)) {
+            segment->subscribers[slot].active = FALSE;
+        }
+    }
+
+    // Claim a free subscriber slot. The slot's event is created before the slot
+    // is marked active so that publishers never find an active slot without an
+    // event.
+    for (int slot = 0; slot < static_cast<int>(subscriberMax); ++slot) {
+        subscriber = &segment->subscribers[slot];
+        if (subscriber->active) {
+            continue;
+        }
+        event = CreateEvent(security, FALSE, FALSE, eventName(slot).c_str());
+        if (NULL == event) {
+            continue;
+        }
+        if (ERROR_ALREADY_EXISTS == GetLastError()) {
+            // The previous owner of this slot is still shutting down.
+            CloseHandle(event);
+            continue;
+        }
+        subscriber->scope = scope_;
+        copyName(subscriber->name, name_);
+        subscriber->active = TRUE;
+        event_ = event;
+        slot_ = slot;
+        version_ = segment->version;
+        break;
+    }
+    ReleaseMutex(lock_);
+
+    if (NULL != security) {
+        LocalFree(security->lpSecurityDescriptor);
+    }
+}
+
+EnvSubscription::~EnvSubscription ()
+{
+    bool           locked;
+    SharedSegment *segment = static_cast<SharedSegment *>(segment_);
+
+    // The slot is freed even if the mutex can't be acquired, since freeing it
+    // is a single store that publishers can't observe half done.
+    if (-1 != slot_) {
+        locked = acquire(lock_);
+        InterlockedExchange(&segment->subscribers[slot_].active, FALSE);
+        if (locked) {
+            ReleaseMutex(lock_);
+        }
+    }
+    if (NULL != event_) {
+        CloseHandle(event_);
+    }
+    if (NULL != segment_) {
+        UnmapViewOfFile(segment_);
+    }
+    if (NULL != mapping_) {
+        CloseHandle(mapping_);
+    }
+    if (NULL != lock_) {
+        CloseHandle(lock_);
+    }
+}
+
+bool EnvSubscription::wait (env_change &change, unsigned long timeout)
+{
+    bool           found;
+    SharedSegment *segment = static_cast<SharedSegment *>(segment_);
+
+    if (-1 == slot_) {
+        return false;
+    }
+
+    for (;;) {
+        if (!acquire(lock_)) {
+            return false;
+        }
+        found = next(segment, scope_, name_, version_, change);
+        ReleaseMutex(lock_);
+        if (found) {
+            return true;
+        }
+
+        if (WAIT_OBJECT_0 != WaitForSingleObject(event_, timeout)) {
+            return false;
+        }
+    }
+}
+
+void EnvSubscription::publish (env_scope scope, std::string const &name)
+{
+    SharedChange const *entry;
+    HANDLE              event;
+    HANDLE              lock;
+    HANDLE              mapping;
+    SharedSegment      *segment;
+    SharedSubscriber   *subscriber;
+
+    // If nobody has ever subscribed in this session, the segment doesn't exist
+    // and there is nobody to notify.
+    mapping = OpenFileMapping(FILE_MAP_ALL_ACCESS, FALSE, mappingName);
+    if (NULL == mapping) {
+        return;
+    }
+    segment = static_cast<SharedSegment *>(MapViewOfFile(mapping,
+                                                         FILE_MAP_ALL_ACCESS,
+                                                         0,
+                                                         0,
+                                                         0));
+    lock = OpenMutex(SYNCHRONIZE | MUTEX_MODIFY_STATE, FALSE, lockName);
+    if ((NULL == segment) || (NULL == lock)) {
+        if (NULL != segment) {
+            UnmapViewOfFile(segment);
+        }
+        CloseHandle(mapping);
+        return;
+    }
+
+    // If the mutex can't be acquired in time, the change is not published
+    // rather than holding up the caller's edit.
+    if (!acquire(lock)) {
+        CloseHandle(lock);
+        UnmapViewOfFile(segment);
+        CloseHandle(mapping);
+        return;
+    }
+
+    entry = record(segment, scope, name);
+
+    // Wake up only the subscribers that are interested in this change.
+    for (unsigned int slot = 0; slot < subscriberMax; ++slot) {
+        subscriber = &segment->subscribers[slot];
+        if (!subscriber->active ||
+            !matches(subscriber->scope, subscriber->name, scope, entry->name)) {
+            continue;
+        }
+        event = OpenEvent(EVENT_MODIFY_STATE,
+                          FALSE,
+                          eventName(static_cast<int>(slot)).c_str());
+        if (NULL == event) {
+            if (ERROR_FILE_NOT_FOUND == GetLastError()) {
+                // The subscriber's process exited without unsubscribing, which
+                // destroyed its event. Free the slot.
+                subscriber->active = FALSE;
+            }
+            continue;
+        }
+        SetEvent(event);
+        CloseHandle(event);
+    }
+
+    ReleaseMutex(lock);
+
+    CloseHandle(lock);
+    UnmapViewOfFile(segment);
+    CloseHandle(mapping);
+}
+#else
+EnvSubscription::EnvSubscription (env_scope scope, std::string const &name)
+    : event_(NULL),
+      lock_(NULL),
+      mapping_(NULL),
+      name_(name),
+      scope_(scope),
+      segment_(NULL),
+      slot_(-1),
+      version_(0)
+{
+    SharedSegment    *segment;
+    SharedSubscriber *subscriber;
+
+    segment = openSegment(true);
+    if (NULL == segment) {
+        return;
+    }
+    segment_ = segment;
+
+    if (!acquire(&segment->lock)) {
+        return;
+    }
+
+    // Free the slots of subscribers that exited without unsubscribing.
+    for (unsigned int slot = 0; slot < subscriberMax; ++slot) {
+        subscriber = &segment->subscribers[slot];
+        if (subscriber->active && abandoned(*subscriber)) {
+            subscriber->active = 0;
+        }
+    }
+
+    // Claim a free subscriber slot. Its futex word is left as it is, since a
+    // subscriber only ever compares it with the value it read before sleeping.
+    for (unsigned int slot = 0; slot < subscriberMax; ++slot) {
+        subscriber = &segment->subscribers[slot];
+        if (subscriber->active) {
+            continue;
+        }
+        subscriber->scope = scope_;
+        copyName(subscriber->name, name_);
+        subscriber->process = getpid();
+        subscriber->active = 1;
+        slot_ = static_cast<int>(slot);
+        version_ = segment->version;
+        break;
+    }
+    pthread_mutex_unlock(&segment->lock);
+}
+
+EnvSubscription::~EnvSubscription ()
+{
+    bool           locked;
+    SharedSegment *segment = static_cast<SharedSegment *>(segment_);
+
+    // The slot is freed even if the mutex can't be acquired, since freeing it
+    // is a single store that publishers can't observe half done.
+    if (-1 != slot_) {
+        locked = acquire(&segment->lock);
+        __sync_lock_test_and_set(&segment->subscribers[slot_].active, 0);
+        if (locked) {
+            pthread_mutex_unlock(&segment->lock);
+        }
+    }
+    if (NULL != segment_) {
+        munmap(segment_, sizeof(SharedSegment));
+    }
+}
+
+bool EnvSubscription::wait (env_change &change, unsigned long timeout)
+{
+    bool              found;
+    struct timespec   interval;
+    SharedSegment    *segment = static_cast<SharedSegment *>(segment_);
+    SharedSubscriber *subscriber;
+    int               woken;
+
+    if (-1 == slot_) {
+        return false;
+    }
+    subscriber = &segment->subscribers[slot_];
+    interval.tv_sec = timeout / 1000;
+    interval.tv_nsec = static_cast<long>(timeout % 1000) * 1000000;
+
+    for (;;) {
+        // Note the futex word before looking for changes, so that a change
+        // published after looking makes the wait return at once instead of
+        // being slept through.
+        woken = __sync_fetch_and_add(&subscriber->wake, 0);
+
+        if (!acquire(&segment->lock)) {
+            return false;
+        }
+        found = next(segment, scope_, name_, version_, change);
+        pthread_mutex_unlock(&segment->lock);
+        if (found) {
+            return true;
+        }
+
+        if ((0 != syscall(SYS_futex,
+                          &subscriber->wake,
+                          FUTEX_WAIT,
+                          woken,
+                          &interval,
+                          NULL,
+                          0)) &&
+            (ETIMEDOUT == errno)) {
+            return false;
+        }
+    }
+}
+
+void EnvSubscription::publish (env_scope scope, std::string const &name)
+{
+    SharedChange const *entry;
+    SharedSegment      *segment;
+    SharedSubscriber   *subscriber;
+
+    // If nobody has ever subscribed, the segment doesn't exist and there is
+    // nobody to notify.
+    segment = openSegment(false);
+    if (NULL == segment) {
+        return;
+    }
+
+    // If the mutex can't be acquired in time, the change is not published
+    // rather than holding up the caller's edit.
+    if (!acquire(&segment->lock)) {
+        munmap(segment, sizeof(SharedSegment));
+        return;
+    }
+
+    entry = record(segment, scope, name);
+
+    // Wake up only the subscribers that are interested in this change.
+    for (unsigned int slot = 0; slot < subscriberMax; ++slot) {
+        subscriber = &segment->subscribers[slot];
+        if (!subscriber->active ||
+            !matches(subscriber->scope, subscriber->name, scope, entry->name)) {
+            continue;
+        }
+        if (abandoned(*subscriber)) {
+            subscriber->active = 0;
+            continue;
+        }
+        wake(subscriber);
+    }
+
+    pthread_mutex_unlock(&segment->lock);
+
+    munmap(segment, sizeof(SharedSegment));
+}
+#endif
+
+bool EnvSubscription::subscribed () const
+{
+    return -1 != slot_;
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  editenv - Environment Change Subscription C++ Class Header
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef EDITENV_ENV_SUBSCRIPTION
+#define EDITENV_ENV_SUBSCRIPTION
+
+#include <string>
+
+#include "editenvTypes.hpp"
+
+// This class lets a process receive notifications about changes made to the
+// stored environment without having to listen for WM_SETTINGCHANGE. Changes
+// are recorded in a ring buffer in shared memory, and only the subscribers
+// whose scope and name match a change are woken up. Each notification carries
+// the name of the changed variable, so a subscriber can re-read just that
+// variable instead of the whole environment.
+//
+// Note: The shared memory lives in the session's Local namespace, so changes
+//       are only delivered to subscribers in the same session. Only the
+//       user who first subscribed in the session (along with the local
+//       system and administrators) can publish or subscribe. Changes are
+//       delivered regardless of which process is elevated.
+//
+// On Linux, which has no WM_SETTINGCHANGE to replace, the ring buffer lives in
+// a POSIX shared memory object that only the calling user can open, so
+// changes are delivered to that user's subscribers in any session. Each
+// subscriber sleeps on a futex in its own slot, which publishers wake only for
+// matching changes.
+class editenv::EnvSubscription
+{
+public:
+    // Subscribes to changes made to the stored environment.
+    //
+    // scope [in]    Environment scope to watch (user or system environment).
+    //               Pass es_invalid to watch both scopes.
+    //
+    // name [in]     Name of the variable to watch (case insensitive). Pass the
+    //               empty string to watch all variables.
+    EnvSubscription (env_scope scope, std::string const &name);
+
+    // Cancels the subscription.
+    ~EnvSubscription ();
+
+    // Indicates whether the subscription was successfully registered. It is
+    // not if every slot is taken, or if the shared segment stays locked by
+    // another process for 100 milliseconds.
+    //
+    // Return Value: Returns true if the subscription is registered and will
+    //               receive changes.
+    bool subscribed () const;
+
+    // Retrieves the next change that matches the subscription, waiting for one
+    // to be made if necessary. If the subscriber has fallen so far behind that
+    // changes were dropped from the ring buffer, a single change with the
+    // overflow flag set (and an empty name) is returned instead, and the
+    // subscriber should re-read every variable it is interested in.
+    //
+    // change [out]     Receives the description of the change.
+    //
+    // timeout [in]     Maximum time to wait, in milliseconds.
+    //
+    // Return Value: Returns true if a change was retrieved, or false if the
+    //               timeout elapsed first (or the shared segment stayed locked
+    //               by another process for 100 milliseconds).
+    bool wait (env_change &change, unsigned long timeout);
+
+    // Records a change to the stored environment and wakes up every subscriber
+    // whose scope and name match it. Does nothing if there are no subscribers,
+    // or if the shared segment stays locked by another process for 100
+    // milliseconds, so that a hung subscriber can't hold up the caller.
+    //
+    // scope [in]    Scope of the changed variable.
+    //
+    // name [in]     Name of the changed variable.
+    //
+    // Return Value: Nothing.
+    static void publish (env_scope scope, std::string const &name);
+
+private:
+    // Subscriptions own operating system resources, so they cannot be copied.
+    EnvSubscription (EnvSubscription const &other);
+    EnvSubscription & operator = (EnvSubscription const &other);
+
+    // Private Data:
+    void          *event_;   // Event signaled on matching changes (Windows).
+    void          *lock_;    // Mutex protecting the segment (Windows).
+    void          *mapping_; // File mapping backing the segment (Windows).
+    std::string    name_;    // Name of the watched variable (or empty).
+    env_scope      scope_;   // Watched scope (or es_invalid for both).
+    void          *segment_; // Mapped view of the shared segment.
+    int            slot_;    // Subscriber slot in the segment (or -1).
+    unsigned long  version_; // Version of the last change examined.
+};
+
+#endif // EDITENV_ENV_SUBSCRIPTION
\ No newline at end of file
@@ -22,64 +22,90 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <cassert>
-#include <limits>
-#include <windows.h>
-
-#undef max // unbelievable
+#include <cstddef>
 
+#include "BasicEnvVar.hpp"
 #include "EnvVar.hpp"
+#include "RegistryBackend.hpp"
 
 using namespace editenv;
 
-// Global Constants
-static UINT const  broadcastTimeout = 100; // in milliseconds
-static char const *userEnvSubKey    = "Environment";
-static char const *systemEnvSubKey  = "System\\CurrentControlSet\\Control\\"
-                                      "Session Manager\\Environment";
+// Interface to the scope-specific variable held by an EnvVar object.
+class EnvVar::Impl_
+{
+public:
+    virtual ~Impl_ ()
+    {
+    }
 
-EnvVar::EnvVar (env_scope scope, std::string const &name)
-    : name_(name),
-      scope_(es_invalid)
+    virtual Impl_ * clone () const = 0;
+    virtual unsigned int cut (std::string const &text) = 0;
+    virtual void paste (std::string const &text) = 0;
+    virtual void set (std::string const &text) = 0;
+    virtual void unset () = 0;
+    virtual std::string value () const = 0;
+};
+
+// A registry environment variable in the given scope.
+template <env_scope Scope>
+class EnvVar::ScopedImpl_ : public EnvVar::Impl_
 {
-    PBYTE       data;
-    HKEY        key;
-    DWORD       size;
-    LONG        status;
-    HKEY        subKey;
-    char const *subKeyName;
+public:
+    explicit ScopedImpl_ (std::string const &name)
+        : var_(name)
+    {
+    }
+
+    Impl_ * clone () const
+    {
+        return new ScopedImpl_(*this);
+    }
+
+    unsigned int cut (std::string const &text)
+    {
+        return var_.cut(text);
+    }
+
+    void paste (std::string const &text)
+    {
+        var_.paste(text);
+    }
+
+    void set (std::string const &text)
+    {
+        var_.set(text);
+    }
+
+    void unset ()
+    {
+        var_.unset();
+    }
+
+    std::string value () const
+    {
+        return var_.value();
+    }
 
+private:
+    BasicEnvVar<Scope, RegistryBackend> var_;
+};
+
+EnvVar::EnvVar (env_scope scope, std::string const &name)
+    : impl_(NULL)
+{
     switch (scope) {
     case es_system:
-        key = HKEY_LOCAL_MACHINE;
-        subKeyName = systemEnvSubKey;
+        impl_ = new ScopedImpl_<es_system>(name);
         break;
 
     case es_user:
-        key = HKEY_CURRENT_USER;
-        subKeyName = userEnvSubKey;
+        impl_ = new ScopedImpl_<es_user>(name);
         break;
 
     default:
         assert(false);
-        return;
-    }
-    scope_ = scope;
-
-    RegOpenKeyEx(key, subKeyName, 0, KEY_QUERY_VALUE | KEY_SET_VALUE, &subKey);
-    status = RegQueryValueEx(subKey, name_.c_str(), 0, NULL, NULL, &size);
-    if (ERROR_SUCCESS != status) {
-        // This environment variable doesn't exist. Assign this EnvVar object's
-        // value the empty string.
-        value_ = "";
-    } else {
-        // This environment variable already exists. Assign its value to this
-        // EnvVar object.
-        data = new BYTE [size];
-        RegQueryValueEx(subKey, name_.c_str(), 0, NULL, data, &size);
-        value_ = reinterpret_cast<char const *>(data);
-        delete [] data;
+        break;
     }
-    RegCloseKey(key);
 }
 
 EnvVar::EnvVar (EnvVar const &other)
@@ -104,194 +130,56 @@ EnvVar & EnvVar::operator = (EnvVar const &other)
 
 unsigned int EnvVar::cut (std::string const &text)
 {
-    size_t const sizeMax = std::numeric_limits<size_t>::max();
-
-    unsigned int  count = 0;
-    HKEY          key;
-    size_t        length;
-    size_t        pos;
-    HKEY          subKey;
-    char const   *subKeyName;
-
-    if (es_invalid == scope_) {
+    if (NULL == impl_) {
         return 0;
     }
 
-    switch (scope_) {
-    case es_system:
-        key = HKEY_LOCAL_MACHINE;
-        subKeyName = systemEnvSubKey;
-        break;
-
-    case es_user:
-        key = HKEY_CURRENT_USER;
-        subKeyName = userEnvSubKey;
-        break;
-    }
-
-    // Replace every instance of text with the empty string.
-    pos = value_.find(text);
-    length = text.length();
-    while (sizeMax != pos) {
-        ++count;
-        value_.replace(pos, length, "");
-        pos = value_.find(text);
-    }
-
-    // Write the new value to the registry.
-    RegOpenKeyEx(key, subKeyName, 0, KEY_QUERY_VALUE | KEY_SET_VALUE, &subKey);
-    RegSetValueEx(subKey,
-                  name_.c_str(),
-                  0,
-                  REG_EXPAND_SZ,
-                  reinterpret_cast<BYTE const *>(value_.c_str()),
-                  value_.length() + 1);
-    RegCloseKey(key);
-
-    // Notify everyone of the change.
-    broadcastChange_();
-
-    return count;
+    return impl_->cut(text);
 }
 
 void EnvVar::paste (std::string const &text)
 {
-    HKEY        key;
-    HKEY        subKey;
-    char const *subKeyName;
-
-    if (es_invalid == scope_) {
+    if (NULL == impl_) {
         return;
     }
 
-    switch (scope_) {
-    case es_system:
-        key = HKEY_LOCAL_MACHINE;
-        subKeyName = systemEnvSubKey;
-        break;
-
-    case es_user:
-        key = HKEY_CURRENT_USER;
-        subKeyName = userEnvSubKey;
-        break;
-    }
-
-    // Append text to the current value.
-    value_ += text;
-
-    // Write the new value to the registry.
-    RegOpenKeyEx(key, subKeyName, 0, KEY_QUERY_VALUE | KEY_SET_VALUE, &subKey);
-    RegSetValueEx(subKey,
-                  name_.c_str(),
-                  0,
-                  REG_EXPAND_SZ,
-                  reinterpret_cast<BYTE const *>(value_.c_str()),
-                  value_.length() + 1);
-    RegCloseKey(key);
-
-    // Notify everyone of the change.
-    broadcastChange_();
+    impl_->paste(text);
 }
 
 void EnvVar::set (std::string const &text)
 {
-    HKEY        key;
-    HKEY        subKey;
-    char const *subKeyName;
-
-    if (es_invalid == scope_) {
+    if (NULL == impl_) {
         return;
     }
 
-    switch (scope_) {
-    case es_system:
-        key = HKEY_LOCAL_MACHINE;
-        subKeyName = systemEnvSubKey;
-        break;
-
-    case es_user:
-        key = HKEY_CURRENT_USER;
-        subKeyName = userEnvSubKey;
-        break;
-    }
-
-    // Assign the new value.
-    value_ = text;
-
-    // Write the new value to the registry.
-    RegOpenKeyEx(key, subKeyName, 0, KEY_SET_VALUE, &subKey);
-    RegSetValueEx(subKey,
-                  name_.c_str(),
-                  0,
-                  REG_EXPAND_SZ,
-                  reinterpret_cast<const BYTE *>(value_.c_str()),
-                  value_.length() + 1);
-    RegCloseKey(key);
-
-    // Notify everyone of the change.
-    broadcastChange_();
+    impl_->set(text);
 }
 
 void EnvVar::unset ()
 {
-    HKEY        key;
-    HKEY        subKey;
-    char const *subKeyName;
-
-    if (es_invalid == scope_) {
+    if (NULL == impl_) {
         return;
     }
 
-    switch (scope_) {
-    case es_system:
-        key = HKEY_LOCAL_MACHINE;
-        subKeyName = systemEnvSubKey;
-        break;
-
-    case es_user:
-        key = HKEY_CURRENT_USER;
-        subKeyName = userEnvSubKey;
-        break;
-    }
-
-    // Assign the empty string for the EnvVar object's value.
-    value_ = "";
-
-    // Delete the value from the registry.
-    RegOpenKeyEx(key, subKeyName, 0, KEY_SET_VALUE, &subKey);
-    RegDeleteValue(subKey, name_.c_str());
-    RegCloseKey(key);
-
-    // Notify everyone of the change.
-    broadcastChange_();
+    impl_->unset();
 }
 
 std::string EnvVar::value () const
 {
-    return value_;
-}
+    if (NULL == impl_) {
+        return "";
+    }
 
-void EnvVar::broadcastChange_ ()
-{
-    DWORD_PTR result;
-
-    // Broadcast WM_SETTINGCHANGE
-    SendMessageTimeout(HWND_BROADCAST,
-                       WM_SETTINGCHANGE,
-                       NULL,
-                       reinterpret_cast<LPARAM>("Environment"),
-                       SMTO_NORMAL,
-                       broadcastTimeout,
-                       &result);
+    return impl_->value();
 }
 
 void EnvVar::copy_ (EnvVar const &other)
 {
-    name_  = other.name_;
-    scope_ = other.scope_;
-    value_ = other.value_;
+    impl_ = (NULL == other.impl_) ? NULL : other.impl_->clone();
 }
 
 void EnvVar::destroy_ ()
 {
+    delete impl_;
+    impl_ = NULL;
 }
\ No newline at end of file
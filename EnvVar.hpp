@@ -29,6 +29,8 @@
 #include "editenvTypes.hpp"
 
 // This class provides a convenient object interface to environment variables.
+// The scope is chosen at run time; see BasicEnvVar for a variant with the scope
+// and storage backend fixed at compile time.
 class editenv::EnvVar
 {
 public:
@@ -58,14 +60,16 @@ public:
     EnvVar & operator = (EnvVar const &other);
 
     // Removes all matching instance of the specified text from the environment
-    // variable's value.
+    // variable's value, as currently stored (which may have been changed since
+    // this object read it).
     //
     // text [in]    Text to cut from the variable's value.
     //
     // Return Value: Returns the number of matching instances that were cut.
     unsigned int cut (std::string const &text);
 
-    // Appends the specified text to the variable's current value.
+    // Appends the specified text to the variable's value, as currently stored
+    // (which may have been changed since this object read it).
     //
     // text [in]    Text to append to the variable's value.
     //
@@ -92,11 +96,11 @@ public:
     std::string value () const;
     
 private:
-    // Private function that broadcasts a WM_SETTINGCHANGE message to notify
-    // that the environment has been changed.
-    //
-    // Return Value: Nothing.
-    void broadcastChange_ ();
+    // Private classes that hold the variable in one of the supported scopes.
+    // The scope is examined only when the object is constructed, after which
+    // every call is forwarded to a BasicEnvVar for that scope (see EnvVar.cpp).
+    class Impl_;
+    template <env_scope Scope> class ScopedImpl_;
 
     // Private function that copies the specified environment variable object's
     // data to the current object.
@@ -109,17 +113,11 @@ private:
     // Private function that releases all resources used by the environment
     // variable object.
     //
-    // Note: As of this writing, environment variable objects do not allocate
-    //       any dynamic resources, so calling this function is effectively a
-    //       no-op.
-    //
     // Return Value: Nothing.
     void destroy_ ();
 
     // Private Data:
-    std::string name_;  // The environment variable's name.
-    env_scope   scope_; // Scope of the environment variable (user or system).
-    std::string value_; // The environment variable's value.
+    Impl_ *impl_; // The scope-specific variable (or NULL if scope is invalid).
 };
 
 #endif // EDITENV_ENV_VAR
\ No newline at end of file
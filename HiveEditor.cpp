@@ -0,0 +1,507 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  editenv - Offline User Hive Editor C++ Class Implementation
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <limits>
+#include <map>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+
+#undef max // unbelievable
+#else
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <pthread.h>
+#include <strings.h>
+#include <unistd.h>
+#endif
+
+#include "HiveEditor.hpp"
+#include "PathList.hpp"
+
+using namespace editenv;
+
+#ifdef _WIN32
+// Global Constants
+static char const *userEnvSubKey = "Environment";
+#endif
+
+// A variable read from a hive, along with any edits made to it so far.
+struct HiveVariable
+{
+    bool        existed;  // Whether the variable existed before the edits.
+    bool        exists;   // Whether the variable exists after the edits.
+    std::string original; // The variable's value before the edits.
+    std::string value;    // The variable's value after the edits.
+};
+
+// Orders variable names without regard to case, as the registry does.
+struct HiveNameLess
+{
+    bool operator () (std::string const &left, std::string const &right) const
+    {
+#ifdef _WIN32
+        return lstrcmpiA(left.c_str(), right.c_str()) < 0;
+#else
+        return strcasecmp(left.c_str(), right.c_str()) < 0;
+#endif
+    }
+};
+
+typedef std::map<std::string, HiveVariable, HiveNameLess> HiveVariables;
+
+// Work shared by the threads applying a change set to many hives.
+struct HiveWork
+{
+    HiveEditor const   *editor;
+    char const * const *hives;
+    unsigned int        hiveCount;
+    long volatile       next;    // Index of the next hive to be claimed.
+    long               *results;
+};
+
+// Applies a single edit to a variable.
+static void editVariable (HiveVariable      &var,
+                          env_op             op,
+                          std::string const &text)
+{
+    size_t const sizeMax = std::numeric_limits<size_t>::max();
+
+    size_t pos;
+
+    switch (op) {
+    case eo_cut:
+        // Cutting nothing leaves the value as it is.
+        if (text.empty()) {
+            break;
+        }
+        pos = var.value.find(text);
+        while (sizeMax != pos) {
+            var.value.replace(pos, text.length(), "");
+            pos = var.value.find(text);
+        }
+        break;
+
+    case eo_paste:
+        var.value += text;
+        var.exists = true;
+        break;
+
+    case eo_set:
+        var.value = text;
+        var.exists = true;
+        break;
+
+    case eo_unset:
+        var.value = "";
+        var.exists = false;
+        break;
+
+    case eo_path_add:
+        pathListAdd(var.value, text);
+        var.exists = true;
+        break;
+
+    case eo_path_remove:
+        pathListRemove(var.value, text);
+        break;
+    }
+}
+
+// Determines whether the edits made to a variable changed it.
+static bool changed (HiveVariable const &var)
+{
+    return (var.exists != var.existed) || (var.value != var.original);
+}
+
+#ifdef _WIN32
+// Reads a variable from the hive's environment key.
+static void readVariable (HKEY key, std::string const &name, HiveVariable &var)
+{
+    PBYTE data;
+    DWORD size;
+
+    var.existed = false;
+    var.exists = false;
+    var.original = "";
+    var.value = "";
+
+    if (ERROR_SUCCESS != RegQueryValueEx(key,
+                                         name.c_str(),
+                                         0,
+                                         NULL,
+                                         NULL,
+                                         &size)) {
+        return;
+    }
+    data = new BYTE [size + 1];
+    if (ERROR_SUCCESS == RegQueryValueEx(key,
+                                         name.c_str(),
+                                         0,
+                                         NULL,
+                                         data,
+                                         &size)) {
+        data[size] = '\0';
+        var.existed = true;
+        var.exists = true;
+        var.original = reinterpret_cast<char const *>(data);
+        var.value = var.original;
+    }
+    delete [] data;
+}
+#else
+// Reads the stand-in for a hive, a text file holding one NAME=value line per
+// variable.
+static long readHive (char const *hive, HiveVariables &variables)
+{
+    size_t const sizeMax = std::numeric_limits<size_t>::max();
+
+    char         buffer [4096];
+    std::string  contents;
+    int          descriptor;
+    size_t       end;
+    size_t       equals;
+    std::string  line;
+    ssize_t      size;
+    size_t       start = 0;
+    HiveVariable var;
+
+    descriptor = open(hive, O_RDONLY);
+    if (-1 == descriptor) {
+        return errno;
+    }
+    for (;;) {
+        size = read(descriptor, buffer, sizeof(buffer));
+        if (0 == size) {
+            break;
+        }
+        if (-1 == size) {
+            if (EINTR == errno) {
+                continue;
+            }
+            size = errno;
+            close(descriptor);
+            return static_cast<long>(size);
+        }
+        contents.append(buffer, size);
+    }
+    close(descriptor);
+
+    var.existed = true;
+    var.exists = true;
+    while (start < contents.length()) {
+        end = contents.find('\n', start);
+        if (sizeMax == end) {
+            end = contents.length();
+        }
+        line = contents.substr(start, end - start);
+        start = end + 1;
+
+        equals = line.find('=');
+        if ((sizeMax == equals) || (0 == equals)) {
+            continue;
+        }
+        var.original = line.substr(equals + 1);
+        var.value = var.original;
+        variables[line.substr(0, equals)] = var;
+    }
+
+    return 0;
+}
+
+// Writes the stand-in for a hive once: the variables are written to a
+// temporary file, which is synced and then renamed over the hive.
+static long writeHive (char const *hive, HiveVariables const &variables)
+{
+    std::string contents;
+    int         descriptor;
+    long        status = 0;
+    std::string temporary = std::string(hive) + ".XXXXXX";
+    ssize_t     size;
+    size_t      written = 0;
+
+    for (HiveVariables::const_iterator i = variables.begin();
+         variables.end() != i;
+         ++i) {
+        if (i->second.exists) {
+            contents += i->first + "=" + i->second.value + "\n";
+        }
+    }
+
+    descriptor = mkstemp(&temporary[0]);
+    if (-1 == descriptor) {
+        return errno;
+    }
+    while ((0 == status) && (written < contents.length())) {
+        size = write(descriptor,
+                     contents.data() + written,
+                     contents.length() - written);
+        if (-1 == size) {
+            if (EINTR != errno) {
+                status = errno;
+            }
+            continue;
+        }
+        written += size;
+    }
+    if ((0 == status) && (0 != fsync(descriptor))) {
+        status = errno;
+    }
+    if ((0 != close(descriptor)) && (0 == status)) {
+        status = errno;
+    }
+    if ((0 == status) && (0 != rename(temporary.c_str(), hive))) {
+        status = errno;
+    }
+    if (0 != status) {
+        unlink(temporary.c_str());
+    }
+
+    return status;
+}
+#endif
+
+// Applies the change set to hives until none are left.
+static void applyHives (HiveWork *work)
+{
+    long index;
+
+    for (;;) {
+#ifdef _WIN32
+        index = InterlockedIncrement(&work->next) - 1;
+#else
+        index = __sync_fetch_and_add(&work->next, 1);
+#endif
+        if (static_cast<unsigned long>(index) >= work->hiveCount) {
+            break;
+        }
+        work->results[index] = work->editor->apply(work->hives[index]);
+    }
+}
+
+// Thread procedure for the worker threads.
+#ifdef _WIN32
+static DWORD WINAPI applyWorker (LPVOID parameter)
+{
+    applyHives(static_cast<HiveWork *>(parameter));
+
+    return 0;
+}
+#else
+static void * applyWorker (void *parameter)
+{
+    applyHives(static_cast<HiveWork *>(parameter));
+
+    return NULL;
+}
+#endif
+
+HiveEditor::HiveEditor (env_edit const *edits, unsigned int editCount)
+{
+    Edit_ edit;
+
+    edits_.reserve(editCount);
+    for (unsigned int i = 0; i < editCount; ++i) {
+        edit.op = edits[i].op;
+        edit.name = edits[i].name;
+        edit.text = (NULL == edits[i].text) ? "" : edits[i].text;
+        edits_.push_back(edit);
+    }
+}
+
+#ifdef _WIN32
+long HiveEditor::apply (char const *hive) const
+{
+    HiveVariables::iterator found;
+    HKEY                    key;
+    HKEY                    root;
+    LONG                    status;
+    HiveVariable            var;
+    HiveVariables           variables;
+
+    // RegLoadAppKey creates a hive that doesn't exist, so check for it first,
+    // lest a mistyped path leave a new, empty hive behind.
+    if (INVALID_FILE_ATTRIBUTES == GetFileAttributes(hive)) {
+        status = static_cast<LONG>(GetLastError());
+        return (ERROR_PATH_NOT_FOUND == status) ? ERROR_FILE_NOT_FOUND : status;
+    }
+
+    // Load the hive privately. It is unloaded again when the last handle to it
+    // is closed. This fails if the hive is already loaded, e.g. because its
+    // user is logged on.
+    status = RegLoadAppKey(hive, &root, KEY_ALL_ACCESS, 0, 0);
+    if (ERROR_SUCCESS != status) {
+        return status;
+    }
+    status = RegCreateKeyEx(root,
+                            userEnvSubKey,
+                            0,
+                            NULL,
+                            REG_OPTION_NON_VOLATILE,
+                            KEY_QUERY_VALUE | KEY_SET_VALUE,
+                            NULL,
+                            &key,
+                            NULL);
+    if (ERROR_SUCCESS != status) {
+        RegCloseKey(root);
+        return status;
+    }
+
+    // Apply every edit in memory, reading each variable only once.
+    for (size_t i = 0; i < edits_.size(); ++i) {
+        found = variables.find(edits_[i].name);
+        if (variables.end() == found) {
+            readVariable(key, edits_[i].name, var);
+            found = variables.insert(std::make_pair(edits_[i].name, var)).first;
+        }
+        editVariable(found->second, edits_[i].op, edits_[i].text);
+    }
+
+    // Write each variable whose edits changed it back once, then flush the
+    // hive once.
+    for (HiveVariables::const_iterator i = variables.begin();
+         (variables.end() != i) && (ERROR_SUCCESS == status);
+         ++i) {
+        if (!changed(i->second)) {
+            continue;
+        }
+        if (i->second.exists) {
+            status = RegSetValueEx(
+                key,
+                i->first.c_str(),
+                0,
+                REG_EXPAND_SZ,
+                reinterpret_cast<BYTE const *>(i->second.value.c_str()),
+                static_cast<DWORD>(i->second.value.length() + 1));
+        } else {
+            status = RegDeleteValue(key, i->first.c_str());
+        }
+    }
+    if (ERROR_SUCCESS == status) {
+        status = RegFlushKey(key);
+    }
+
+    RegCloseKey(key);
+    RegCloseKey(root);
+
+    return status;
+}
+#else
+long HiveEditor::apply (char const *hive) const
+{
+    bool                    dirty = false;
+    HiveVariables::iterator found;
+    long                    status;
+    HiveVariable            var;
+    HiveVariables           variables;
+
+    status = readHive(hive, variables);
+    if (0 != status) {
+        return status;
+    }
+
+    // Apply every edit in memory.
+    var.existed = false;
+    var.exists = false;
+    for (size_t i = 0; i < edits_.size(); ++i) {
+        found = variables.find(edits_[i].name);
+        if (variables.end() == found) {
+            found = variables.insert(std::make_pair(edits_[i].name, var)).first;
+        }
+        editVariable(found->second, edits_[i].op, edits_[i].text);
+    }
+
+    // Rewrite the file once, if anything changed.
+    for (HiveVariables::const_iterator i = variables.begin();
+         variables.end() != i;
+         ++i) {
+        dirty = dirty || changed(i->second);
+    }
+    if (!dirty) {
+        return 0;
+    }
+
+    return writeHive(hive, variables);
+}
+#endif
+
+void HiveEditor::applyAll (char const * const *hives,
+                           unsigned int        hiveCount,
+                           long               *results) const
+{
+    unsigned int threadCount;
+    HiveWork     work;
+
+    work.editor = this;
+    work.hives = hives;
+    work.hiveCount = hiveCount;
+    work.next = 0;
+    work.results = results;
+
+#ifdef _WIN32
+    SYSTEM_INFO         info;
+    std::vector<HANDLE> threads;
+
+    GetSystemInfo(&info);
+    threadCount = info.dwNumberOfProcessors;
+#else
+    std::vector<pthread_t> threads;
+    long                   processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+    threadCount = (processors < 1) ? 1 : static_cast<unsigned int>(processors);
+#endif
+    if (threadCount > hiveCount) {
+        threadCount = hiveCount;
+    }
+
+    // The calling thread is one of the workers, so start one fewer thread. If a
+    // thread can't be started, the remaining workers pick up its share.
+    for (unsigned int i = 1; i < threadCount; ++i) {
+#ifdef _WIN32
+        HANDLE thread = CreateThread(NULL, 0, applyWorker, &work, 0, NULL);
+
+        if (NULL != thread) {
+            threads.push_back(thread);
+        }
+#else
+        pthread_t thread;
+
+        if (0 == pthread_create(&thread, NULL, applyWorker, &work)) {
+            threads.push_back(thread);
+        }
+#endif
+    }
+    applyHives(&work);
+
+    for (size_t i = 0; i < threads.size(); ++i) {
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  editenv - Offline User Hive Editor C++ Class Header
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef EDITENV_HIVE_EDITOR
+#define EDITENV_HIVE_EDITOR
+
+#include <string>
+#include <vector>
+
+#include "editenvTypes.hpp"
+
+// This class applies a change set to the user environment stored in registry
+// hive files (such as a profile's NTUSER.DAT) that are not currently loaded.
+// Each hive is loaded privately, its variables are edited in memory, and the
+// results are written and flushed once per hive. Many hives are edited in
+// parallel.
+//
+// On other systems, which have no registry, each hive is stood in for by a text
+// file holding one NAME=value line per variable of the hive's Environment key,
+// so that change sets can be applied (and timed) there too. Each stand-in is
+// rewritten once, by writing a temporary file, syncing it and renaming it over
+// the original.
+class editenv::HiveEditor
+{
+public:
+    // Constructs a hive editor for the given change set. The edits are copied,
+    // so the caller's strings need not outlive the editor.
+    //
+    // edits [in]        The edits to make, in the order to make them.
+    //
+    // editCount [in]    Number of edits.
+    HiveEditor (env_edit const *edits, unsigned int editCount);
+
+    // Applies the change set to a single hive file.
+    //
+    // hive [in]    Path of the hive file.
+    //
+    // Return Value: Returns ERROR_SUCCESS, ERROR_FILE_NOT_FOUND if the hive
+    //               doesn't exist (it is not created), or the Win32 error
+    //               code of the first registry operation that failed. On
+    //               other systems, returns 0, ENOENT if the stand-in doesn't
+    //               exist, or the errno value of the file operation that
+    //               failed.
+    long apply (char const *hive) const;
+
+    // Applies the change set to many hive files in parallel, using one worker
+    // thread per processor. Workers take the next unedited hive as soon as they
+    // finish one, so a slow hive does not hold up the others.
+    //
+    // hives [in]        Paths of the hive files.
+    //
+    // hiveCount [in]    Number of hive files.
+    //
+    // results [out]     Receives the result of apply for each hive, in the same
+    //                   order as the hives.
+    //
+    // Return Value: Nothing.
+    void applyAll (char const * const *hives,
+                   unsigned int        hiveCount,
+                   long               *results) const;
+
+private:
+    // Private type that holds a copy of an edit.
+    struct Edit_
+    {
+        env_op      op;
+        std::string name;
+        std::string text;
+    };
+
+    // Private Data:
+    std::vector<Edit_> edits_; // The change set.
+};
+
+#endif // EDITENV_HIVE_EDITOR
\ No newline at end of file
@@ -0,0 +1,153 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  editenv - In-Memory Environment Storage Backend
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef EDITENV_MEMORY_BACKEND
+#define EDITENV_MEMORY_BACKEND
+
+#include <cctype>
+#include <map>
+#include <string>
+
+#include "editenvTypes.hpp"
+
+// This class is a BasicEnvVar backend that keeps each scope's variables in a
+// map in the current process instead of in the registry. It is intended for
+// testing code that edits the environment without touching the real one.
+// Like the registry, it treats variable names as case insensitive.
+//
+// Example:
+//
+//     BasicEnvVar<es_user, MemoryBackend> path("Path");
+//     path.set("C:\\Tools");
+//     assert(1 == MemoryBackend::notifications<es_user>());
+//
+// Note: The maps are shared by all threads and are not synchronized.
+class editenv::MemoryBackend
+{
+public:
+    template <env_scope Scope>
+    static bool read (std::string const &name, std::string &value)
+    {
+        Variables_::const_iterator found = variables_<Scope>().find(name);
+
+        if (variables_<Scope>().end() == found) {
+            return false;
+        }
+        value = found->second;
+
+        return true;
+    }
+
+    template <env_scope Scope>
+    static void write (std::string const &name, std::string const &value)
+    {
+        variables_<Scope>()[name] = value;
+    }
+
+    template <env_scope Scope>
+    static void remove (std::string const &name)
+    {
+        variables_<Scope>().erase(name);
+    }
+
+    template <env_scope Scope, class Edit>
+    static void update (std::string const &name,
+                        Edit              &edit,
+                        std::string       &value)
+    {
+        if (!read<Scope>(name, value)) {
+            value = "";
+        }
+        edit.apply(value);
+        write<Scope>(name, value);
+    }
+
+    template <env_scope Scope>
+    static void notify (std::string const & /* name */)
+    {
+        ++notifications_<Scope>();
+    }
+
+    // Retrieves the number of change notifications made for a scope since the
+    // scope was last cleared.
+    //
+    // Return Value: Returns the number of notifications.
+    template <env_scope Scope>
+    static unsigned int notifications ()
+    {
+        return notifications_<Scope>();
+    }
+
+    // Deletes every variable in a scope and resets its notification count.
+    //
+    // Return Value: Nothing.
+    template <env_scope Scope>
+    static void clear ()
+    {
+        variables_<Scope>().clear();
+        notifications_<Scope>() = 0;
+    }
+
+private:
+    // Orders variable names without regard to case.
+    struct NameLess_
+    {
+        bool operator () (std::string const &left,
+                          std::string const &right) const
+        {
+            size_t length = (left.length() < right.length()) ?
+                            left.length() : right.length();
+
+            for (size_t i = 0; i < length; ++i) {
+                int l = tolower(static_cast<unsigned char>(left[i]));
+                int r = tolower(static_cast<unsigned char>(right[i]));
+
+                if (l != r) {
+                    return l < r;
+                }
+            }
+
+            return left.length() < right.length();
+        }
+    };
+
+    typedef std::map<std::string, std::string, NameLess_> Variables_;
+
+    template <env_scope Scope>
+    static unsigned int & notifications_ ()
+    {
+        static unsigned int count = 0;
+
+        return count;
+    }
+
+    template <env_scope Scope>
+    static Variables_ & variables_ ()
+    {
+        static Variables_ variables;
+
+        return variables;
+    }
+};
+
+#endif // EDITENV_MEMORY_BACKEND
\ No newline at end of file
@@ -0,0 +1,957 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  editenv - Path Executable Index C++ Class Implementation
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+
+#undef max // unbelievable
+#else
+#include <cerrno>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "PathIndex.hpp"
+#include "PathList.hpp"
+#include "PathOrder.hpp"
+
+#ifdef _WIN32
+#include "EnvVar.hpp"
+#include "RegistryBackend.hpp"
+#endif
+
+using namespace editenv;
+
+// Global Constants
+static unsigned int const  expandDepthMax  = 8;    // nested references
+static size_t const        lookupsMax      = 4096; // names in a lookup log
+static unsigned long const refreshInterval = 1000; // in milliseconds
+#ifdef _WIN32
+static unsigned int const  logOpenTries    = 100;  // while the log is in use
+static DWORD const         logRetryDelay   = 20;   // in milliseconds
+static char const          separator       = '\\';
+#else
+static char const          separator       = '/';
+#endif
+
+// Global Variables
+static long volatile generation = 0; // Number of times the Path was changed.
+
+// Returns a copy of a file name with its case folded the way the file system
+// compares names: lowercased on Windows, and left as it is elsewhere, where
+// names are case sensitive.
+static std::string foldCase (std::string const &text)
+{
+#ifdef _WIN32
+    std::string result = text;
+
+    if (!result.empty()) {
+        CharLowerBuff(&result[0], static_cast<DWORD>(result.length()));
+    }
+
+    return result;
+#else
+    return text;
+#endif
+}
+
+// Retrieves a tick count in milliseconds, for timing refreshes.
+static unsigned long ticks ()
+{
+#ifdef _WIN32
+    return GetTickCount();
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return static_cast<unsigned long>(now.tv_sec) * 1000 +
+           static_cast<unsigned long>(now.tv_nsec / 1000000);
+#endif
+}
+
+// Retrieves the last write time of a directory, in two parts.
+//
+// Return Value: Returns false (and a time of zero) if the directory doesn't
+//               exist.
+static bool modifiedTime (std::string const &path,
+                          unsigned long     &low,
+                          unsigned long     &high)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+
+    if (GetFileAttributesEx(path.c_str(), GetFileExInfoStandard, &attributes)) {
+        low = attributes.ftLastWriteTime.dwLowDateTime;
+        high = attributes.ftLastWriteTime.dwHighDateTime;
+        return true;
+    }
+#else
+    struct stat status;
+
+    if (0 == stat(path.c_str(), &status)) {
+        low = static_cast<unsigned long>(status.st_mtim.tv_nsec);
+        high = static_cast<unsigned long>(status.st_mtime);
+        return true;
+    }
+#endif
+    low = 0;
+    high = 0;
+
+    return false;
+}
+
+// Acquires an index's lock, which serializes its lookups.
+static void enter (void *lock)
+{
+#ifdef _WIN32
+    EnterCriticalSection(static_cast<CRITICAL_SECTION *>(lock));
+#else
+    pthread_mutex_lock(static_cast<pthread_mutex_t *>(lock));
+#endif
+}
+
+// Releases an index's lock.
+static void leave (void *lock)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(static_cast<CRITICAL_SECTION *>(lock));
+#else
+    pthread_mutex_unlock(static_cast<pthread_mutex_t *>(lock));
+#endif
+}
+
+// Keeps a lookup log within lookupsMax names by halving every count and
+// forgetting the names whose count drops to zero, as many times as it takes.
+static void bound (PathIndex::Counts &counts)
+{
+    while (counts.size() > lookupsMax) {
+        for (PathIndex::Counts::iterator i = counts.begin();
+             counts.end() != i;) {
+            i->second /= 2;
+            if (0 == i->second) {
+                counts.erase(i++);
+            } else {
+                ++i;
+            }
+        }
+    }
+}
+
+// Adds the lookup counts in the text of a log file to counts.
+static void parseLog (std::string const &text, PathIndex::Counts &counts)
+{
+    char               *end;
+    std::string         line;
+    std::string         name;
+    std::istringstream  stream(text);
+    unsigned long       value;
+
+    while (std::getline(stream, line)) {
+        value = strtoul(line.c_str(), &end, 10);
+        if (('\t' != *end) || (end == line.c_str())) {
+            continue;
+        }
+        name = end + 1;
+        if (!name.empty() && ('\r' == name[name.length() - 1])) {
+            name.erase(name.length() - 1);
+        }
+        if (!name.empty() && (0 != value)) {
+            counts[foldCase(name)] += value;
+        }
+    }
+}
+
+#ifdef _WIN32
+// Opens a lookup log file, waiting while another process has it open.
+static long openLog (std::string const &file,
+                     DWORD              access,
+                     DWORD              share,
+                     DWORD              disposition,
+                     HANDLE            &handle)
+{
+    long status = ERROR_SUCCESS;
+
+    for (unsigned int i = 0; i < logOpenTries; ++i) {
+        handle = CreateFile(file.c_str(),
+                            access,
+                            share,
+                            NULL,
+                            disposition,
+                            FILE_ATTRIBUTE_NORMAL,
+                            NULL);
+        if (INVALID_HANDLE_VALUE != handle) {
+            return ERROR_SUCCESS;
+        }
+        status = GetLastError();
+        if (ERROR_SHARING_VIOLATION != status) {
+            break;
+        }
+        Sleep(logRetryDelay);
+    }
+
+    return status;
+}
+
+// Reads the lookup counts in an open log file and adds them to counts.
+static long readLog (HANDLE handle, PathIndex::Counts &counts)
+{
+    DWORD       read;
+    DWORD       size;
+    std::string text;
+
+    size = GetFileSize(handle, NULL);
+    if (INVALID_FILE_SIZE == size) {
+        return GetLastError();
+    }
+    if (0 == size) {
+        return ERROR_SUCCESS;
+    }
+    text.resize(size);
+    if (!ReadFile(handle, &text[0], size, &read, NULL)) {
+        return GetLastError();
+    }
+    text.resize(read);
+    parseLog(text, counts);
+
+    return ERROR_SUCCESS;
+}
+#else
+// Opens a lookup log file and locks it, waiting while another process has it
+// locked.
+static long openLog (std::string const &file,
+                     int                flags,
+                     int                operation,
+                     int               &descriptor)
+{
+    long status;
+
+    descriptor = open(file.c_str(), flags, 0666);
+    if (-1 == descriptor) {
+        return errno;
+    }
+    while (0 != flock(descriptor, operation)) {
+        if (EINTR != errno) {
+            status = errno;
+            close(descriptor);
+            return status;
+        }
+    }
+
+    return 0;
+}
+
+// Reads the lookup counts in an open log file and adds them to counts.
+static long readLog (int descriptor, PathIndex::Counts &counts)
+{
+    char        buffer [4096];
+    ssize_t     size;
+    std::string text;
+
+    for (;;) {
+        size = read(descriptor, buffer, sizeof(buffer));
+        if (0 == size) {
+            break;
+        }
+        if (-1 == size) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return errno;
+        }
+        text.append(buffer, size);
+    }
+    parseLog(text, counts);
+
+    return 0;
+}
+#endif
+
+#ifdef _WIN32
+// Reads the stored Path for a scope. For the combined Path, also determines how
+// many of its entries come from the system Path.
+static std::string storedPath (env_scope scope, unsigned int &systemCount)
+{
+    std::vector<std::string> entries;
+    std::string              system;
+    std::string              user;
+
+    systemCount = 0;
+    if (es_invalid != scope) {
+        return EnvVar(scope, "Path").value();
+    }
+
+    // New processes receive the system Path followed by the user Path.
+    system = EnvVar(es_system, "Path").value();
+    user = EnvVar(es_user, "Path").value();
+    pathListSplit(system, entries);
+    systemCount = static_cast<unsigned int>(entries.size());
+    if (system.empty() || user.empty()) {
+        return system + user;
+    }
+
+    return system + ";" + user;
+}
+
+// Looks up a variable referred to by a Path entry, the way it is seen by new
+// processes: the stored user variable takes precedence over the stored system
+// variable. Variables that aren't stored (such as SystemRoot or USERPROFILE)
+// are taken from the current process's environment.
+static bool lookupVariable (std::string const &name, std::string &value)
+{
+    char  *buffer;
+    bool   found = false;
+    DWORD  size;
+
+    if (RegistryBackend::read<es_user>(name, value) ||
+        RegistryBackend::read<es_system>(name, value)) {
+        return true;
+    }
+
+    size = GetEnvironmentVariable(name.c_str(), NULL, 0);
+    if (0 == size) {
+        return false;
+    }
+    buffer = new char [size];
+    if (0 != GetEnvironmentVariable(name.c_str(), buffer, size)) {
+        value = buffer;
+        found = true;
+    }
+    delete [] buffer;
+
+    return found;
+}
+#else
+// Reads the Path for a scope. There is no stored Path, so the process's PATH
+// stands in for every scope, with its colons turned into semicolons. None of
+// its entries count as system entries.
+static std::string storedPath (env_scope /* scope */, unsigned int &systemCount)
+{
+    char const  *value = getenv("PATH");
+    std::string  result = (NULL == value) ? "" : value;
+
+    systemCount = 0;
+    std::replace(result.begin(), result.end(), ':', ';');
+
+    return result;
+}
+
+// Looks up a variable referred to by a Path entry in the process's
+// environment.
+static bool lookupVariable (std::string const &name, std::string &value)
+{
+    char const *found = getenv(name.c_str());
+
+    if (NULL == found) {
+        return false;
+    }
+    value = found;
+
+    return true;
+}
+#endif
+
+// Expands the %NAME% references in a string using lookupVariable. Stored
+// values may themselves contain references, which are expanded in turn (up to
+// a limit, in case variables refer to each other). References to undefined
+// variables are left as they are, as ExpandEnvironmentStrings does.
+static std::string expandStored (std::string const &text, unsigned int depth)
+{
+    size_t const sizeMax = std::numeric_limits<size_t>::max();
+
+    size_t      end;
+    std::string name;
+    size_t      pos = 0;
+    std::string result;
+    size_t      start;
+    std::string value;
+
+    for (;;) {
+        start = text.find('%', pos);
+        if (sizeMax == start) {
+            break;
+        }
+        end = text.find('%', start + 1);
+        if (sizeMax == end) {
+            break;
+        }
+
+        name = text.substr(start + 1, end - start - 1);
+        if (name.empty() || !lookupVariable(name, value)) {
+            // Keep the first '%' and look for a reference starting at the
+            // second one.
+            result += text.substr(pos, end - pos);
+            pos = end;
+            continue;
+        }
+        result += text.substr(pos, start - pos);
+        result += (depth < expandDepthMax) ? expandStored(value, depth + 1) :
+                                             value;
+        pos = end + 1;
+    }
+
+    return result + text.substr(pos);
+}
+
+// Expands the environment variable references in a Path entry and removes any
+// quotes around it. The references are expanded with the stored variables
+// rather than this process's environment, which may be out of date.
+static std::string expandEntry (std::string const &entry)
+{
+    std::string result = expandStored(entry, 0);
+
+    if ((result.length() >= 2) &&
+        ('"' == result[0]) &&
+        ('"' == result[result.length() - 1])) {
+        result = result.substr(1, result.length() - 2);
+    }
+
+    return result;
+}
+
+PathIndex::PathIndex (env_scope scope)
+    : checked_(0),
+      generation_(-1),
+      scope_(scope),
+      stored_(true),
+      systemCount_(0)
+{
+    initialize_();
+}
+
+PathIndex::PathIndex (std::string const &value)
+    : checked_(0),
+      generation_(-1),
+      scope_(es_invalid),
+      stored_(false),
+      systemCount_(0),
+      value_(value)
+{
+    initialize_();
+}
+
+PathIndex::~PathIndex ()
+{
+#ifdef _WIN32
+    DeleteCriticalSection(static_cast<CRITICAL_SECTION *>(lock_));
+    delete static_cast<CRITICAL_SECTION *>(lock_);
+#else
+    pthread_mutex_destroy(static_cast<pthread_mutex_t *>(lock_));
+    delete static_cast<pthread_mutex_t *>(lock_);
+#endif
+}
+
+bool PathIndex::find (std::string const &name,
+                      std::string const &extensions,
+                      std::string       &path)
+{
+    size_t const sizeMax = std::numeric_limits<size_t>::max();
+
+    std::vector<std::string> extensionList;
+    std::string              file;
+    unsigned int             position;
+
+    if (name.empty() || (sizeMax != name.find_first_of("\\/:"))) {
+        // Only bare file names are searched for on the Path.
+        return false;
+    }
+    pathListSplit(extensions, extensionList);
+
+    enter(lock_);
+    refresh_(false);
+    ++lookups_[foldCase(name)];
+    bound(lookups_);
+
+    position = resolve_(name, extensionList, file);
+    if (position < directories_.size()) {
+        path = directories_[position].path;
+        if (separator != path[path.length() - 1]) {
+            path += separator;
+        }
+        path += file;
+    }
+
+    leave(lock_);
+
+    return position < directories_.size();
+}
+
+void PathIndex::lookups (Counts &counts, bool reset)
+{
+    enter(lock_);
+    for (Counts::const_iterator i = lookups_.begin();
+         lookups_.end() != i;
+         ++i) {
+        counts[i->first] += i->second;
+    }
+    if (reset) {
+        lookups_.clear();
+    }
+    leave(lock_);
+}
+
+void PathIndex::record (Counts const &counts)
+{
+    enter(lock_);
+    for (Counts::const_iterator i = counts.begin(); counts.end() != i; ++i) {
+        lookups_[foldCase(i->first)] += i->second;
+    }
+    bound(lookups_);
+    leave(lock_);
+}
+
+unsigned int PathIndex::optimize (env_scope          scope,
+                                  Counts const      &counts,
+                                  std::string const &extensions,
+                                  std::string       &value,
+                                  double            &probesBefore,
+                                  double            &probesAfter)
+{
+    std::vector<std::string>  entries;
+    std::vector<std::string>  extensionList;
+    unsigned int              first;
+    unsigned int              last;
+    Counts                    lookupCounts;
+    unsigned int              moved;
+    unsigned int              n;
+    std::vector<unsigned int> order;
+
+    pathListSplit(extensions, extensionList);
+    for (size_t i = 0; i < extensionList.size(); ++i) {
+        extensionList[i] = foldCase(extensionList[i]);
+    }
+    for (Counts::const_iterator i = counts.begin(); counts.end() != i; ++i) {
+        lookupCounts[foldCase(i->first)] += i->second;
+    }
+    probesBefore = 0;
+    probesAfter = 0;
+    value = "";
+
+    enter(lock_);
+    refresh_(true);
+    pathListSplit(value_, entries);
+    n = static_cast<unsigned int>(directories_.size());
+
+    // Find the directories that belong to the scope being reordered. The
+    // directories before and after them stay where they are.
+    if (!stored_ || (scope_ == scope)) {
+        first = 0;
+        last = n;
+    } else if ((es_invalid == scope_) && (es_system == scope)) {
+        first = 0;
+        last = systemCount_;
+    } else if ((es_invalid == scope_) && (es_user == scope)) {
+        first = systemCount_;
+        last = n;
+    } else {
+        leave(lock_);
+        return 0;
+    }
+
+    moved = pathOrder(index_,
+                      n,
+                      first,
+                      last,
+                      lookupCounts,
+                      extensionList,
+                      order,
+                      probesBefore,
+                      probesAfter);
+    for (unsigned int i = first; i < last; ++i) {
+        if (!value.empty()) {
+            value += ";";
+        }
+        value += entries[order[i]];
+    }
+
+    leave(lock_);
+
+    return moved;
+}
+
+#ifdef _WIN32
+long PathIndex::loadLog (std::string const &file, Counts &counts)
+{
+    HANDLE handle;
+    long   status;
+
+    // A log that hasn't been saved yet is empty.
+    status = openLog(file,
+                     GENERIC_READ,
+                     FILE_SHARE_READ,
+                     OPEN_EXISTING,
+                     handle);
+    if ((ERROR_FILE_NOT_FOUND == status) || (ERROR_PATH_NOT_FOUND == status)) {
+        return ERROR_SUCCESS;
+    }
+    if (ERROR_SUCCESS != status) {
+        return status;
+    }
+    status = readLog(handle, counts);
+    CloseHandle(handle);
+
+    return status;
+}
+
+long PathIndex::saveLog (std::string const &file, Counts const &counts)
+{
+    HANDLE             handle;
+    Counts             merged;
+    long               status;
+    std::ostringstream text;
+    DWORD              written;
+
+    status = openLog(file,
+                     GENERIC_READ | GENERIC_WRITE,
+                     0,
+                     OPEN_ALWAYS,
+                     handle);
+    if (ERROR_SUCCESS != status) {
+        return status;
+    }
+
+    // Merge the counts with those already saved, and rewrite the file.
+    status = readLog(handle, merged);
+    if (ERROR_SUCCESS == status) {
+        for (Counts::const_iterator i = counts.begin();
+             counts.end() != i;
+             ++i) {
+            merged[foldCase(i->first)] += i->second;
+        }
+        bound(merged);
+        for (Counts::const_iterator i = merged.begin();
+             merged.end() != i;
+             ++i) {
+            text << i->second << '\t' << i->first << "\r\n";
+        }
+
+        std::string const contents = text.str();
+
+        if ((INVALID_SET_FILE_POINTER ==
+             SetFilePointer(handle, 0, NULL, FILE_BEGIN)) ||
+            !WriteFile(handle,
+                       contents.data(),
+                       static_cast<DWORD>(contents.length()),
+                       &written,
+                       NULL) ||
+            !SetEndOfFile(handle)) {
+            status = GetLastError();
+        }
+    }
+    CloseHandle(handle);
+
+    return status;
+}
+
+#else
+long PathIndex::loadLog (std::string const &file, Counts &counts)
+{
+    int  descriptor;
+    long status;
+
+    // A log that hasn't been saved yet is empty.
+    status = openLog(file, O_RDONLY, LOCK_SH, descriptor);
+    if (ENOENT == status) {
+        return 0;
+    }
+    if (0 != status) {
+        return status;
+    }
+    status = readLog(descriptor, counts);
+    close(descriptor);
+
+    return status;
+}
+
+long PathIndex::saveLog (std::string const &file, Counts const &counts)
+{
+    int                descriptor;
+    Counts             merged;
+    size_t             offset = 0;
+    ssize_t            size;
+    long               status;
+    std::ostringstream text;
+
+    status = openLog(file, O_RDWR | O_CREAT, LOCK_EX, descriptor);
+    if (0 != status) {
+        return status;
+    }
+
+    // Merge the counts with those already saved, and rewrite the file.
+    status = readLog(descriptor, merged);
+    if (0 == status) {
+        for (Counts::const_iterator i = counts.begin();
+             counts.end() != i;
+             ++i) {
+            merged[foldCase(i->first)] += i->second;
+        }
+        bound(merged);
+        for (Counts::const_iterator i = merged.begin();
+             merged.end() != i;
+             ++i) {
+            text << i->second << '\t' << i->first << "\n";
+        }
+
+        std::string const contents = text.str();
+
+        if (0 != ftruncate(descriptor, 0)) {
+            status = errno;
+        }
+        while ((0 == status) && (offset < contents.length())) {
+            size = pwrite(descriptor,
+                          contents.data() + offset,
+                          contents.length() - offset,
+                          static_cast<off_t>(offset));
+            if (-1 == size) {
+                if (EINTR != errno) {
+                    status = errno;
+                }
+                continue;
+            }
+            offset += size;
+        }
+    }
+    close(descriptor);
+
+    return status;
+}
+#endif
+
+std::string PathIndex::defaultExtensions ()
+{
+#ifdef _WIN32
+    char        *buffer;
+    std::string  result;
+    DWORD        size;
+
+    size = GetEnvironmentVariable("PATHEXT", NULL, 0);
+    if (0 == size) {
+        return result;
+    }
+    buffer = new char [size];
+    if (0 != GetEnvironmentVariable("PATHEXT", buffer, size)) {
+        result = buffer;
+    }
+    delete [] buffer;
+
+    return result;
+#else
+    char const *value = getenv("PATHEXT");
+
+    return (NULL == value) ? "" : value;
+#endif
+}
+
+void PathIndex::invalidate ()
+{
+#ifdef _WIN32
+    InterlockedIncrement(&generation);
+#else
+    __sync_add_and_fetch(&generation, 1);
+#endif
+}
+
+void PathIndex::initialize_ ()
+{
+#ifdef _WIN32
+    lock_ = new CRITICAL_SECTION;
+    InitializeCriticalSection(static_cast<CRITICAL_SECTION *>(lock_));
+#else
+    lock_ = new pthread_mutex_t;
+    pthread_mutex_init(static_cast<pthread_mutex_t *>(lock_), NULL);
+#endif
+}
+
+void PathIndex::refresh_ (bool force)
+{
+    bool                     changed = false;
+    std::vector<std::string> entries;
+    unsigned long            modified;
+    unsigned long            modifiedHigh;
+    unsigned long            now = ticks();
+    std::string              path;
+    std::string              value;
+
+    if (!force &&
+        (generation_ == generation) &&
+        (now - checked_ < refreshInterval)) {
+        return;
+    }
+    checked_ = now;
+
+    value = stored_ ? storedPath(scope_, systemCount_) : value_;
+    if ((generation_ != generation) || (value != value_)) {
+        // The Path itself changed, so list every directory again.
+        generation_ = generation;
+        value_ = value;
+        pathListSplit(value_, entries);
+        directories_.resize(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            directories_[i].path = expandEntry(entries[i]);
+            list_(directories_[i]);
+        }
+        changed = true;
+    } else {
+        // Only list the directories whose entry now expands differently (since
+        // a variable it refers to changed) or that were modified since they
+        // were listed.
+        pathListSplit(value_, entries);
+        for (size_t i = 0; i < directories_.size(); ++i) {
+            Directory_ &directory = directories_[i];
+
+            path = expandEntry(entries[i]);
+            if (path != directory.path) {
+                directory.path = path;
+                list_(directory);
+                changed = true;
+                continue;
+            }
+            modifiedTime(directory.path, modified, modifiedHigh);
+            if ((modified != directory.modified) ||
+                (modifiedHigh != directory.modifiedHigh)) {
+                list_(directory);
+                changed = true;
+            }
+        }
+    }
+
+    if (changed) {
+        rebuild_();
+    }
+}
+
+void PathIndex::list_ (Directory_ &directory)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATA  data;
+    HANDLE           find;
+    std::string      pattern = directory.path;
+#else
+    struct dirent   *entry;
+    DIR             *list;
+    struct stat      status;
+#endif
+
+    directory.files.clear();
+
+    // Record the modification time before listing, so that a change made
+    // while listing is picked up by the next refresh.
+    if (!modifiedTime(directory.path,
+                      directory.modified,
+                      directory.modifiedHigh)) {
+        // The directory doesn't exist (yet).
+        return;
+    }
+
+#ifdef _WIN32
+
+    if (pattern.empty() || ('\\' != pattern[pattern.length() - 1])) {
+        pattern += '\\';
+    }
+    pattern += '*';
+
+    find = FindFirstFile(pattern.c_str(), &data);
+    if (INVALID_HANDLE_VALUE == find) {
+        return;
+    }
+    do {
+        if (0 == (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            directory.files.push_back(foldCase(data.cFileName));
+        }
+    } while (FindNextFile(find, &data));
+    FindClose(find);
+#else
+    list = opendir(directory.path.c_str());
+    if (NULL == list) {
+        return;
+    }
+    for (entry = readdir(list); NULL != entry; entry = readdir(list)) {
+        if (DT_DIR == entry->d_type) {
+            continue;
+        }
+        if ((DT_UNKNOWN == entry->d_type) || (DT_LNK == entry->d_type)) {
+            // Find out what the entry is (or links to).
+            if ((0 != stat((directory.path + separator +
+                            entry->d_name).c_str(),
+                           &status)) ||
+                S_ISDIR(status.st_mode)) {
+                continue;
+            }
+        }
+        directory.files.push_back(foldCase(entry->d_name));
+    }
+    closedir(list);
+#endif
+}
+
+void PathIndex::rebuild_ ()
+{
+    index_.clear();
+    for (unsigned int i = 0; i < directories_.size(); ++i) {
+        std::vector<std::string> const &files = directories_[i].files;
+
+        for (size_t j = 0; j < files.size(); ++j) {
+            std::vector<unsigned int> &positions = index_[files[j]];
+
+            // A directory listed twice on the Path is recorded at both
+            // positions, but the same file is only recorded once for each.
+            if (positions.empty() || (positions.back() != i)) {
+                positions.push_back(i);
+            }
+        }
+    }
+}
+
+unsigned int PathIndex::resolve_ (std::string const              &name,
+                                  std::vector<std::string> const &extensions,
+                                  std::string                    &file) const
+{
+    unsigned int             best;
+    size_t                   candidate = 0;
+    std::vector<std::string> candidates;
+    std::vector<std::string> folded;
+
+    pathCandidates(name, extensions, candidates);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        folded.push_back(foldCase(candidates[i]));
+    }
+    best = pathResolve(index_,
+                       static_cast<unsigned int>(directories_.size()),
+                       folded,
+                       candidate);
+    if (best < directories_.size()) {
+        file = candidates[candidate];
+    }
+
+    return best;
+}
\ No newline at end of file
@@ -0,0 +1,277 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  editenv - Path Executable Index C++ Class Header
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef EDITENV_PATH_INDEX
+#define EDITENV_PATH_INDEX
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "PathOrder.hpp"
+#include "editenvTypes.hpp"
+
+// This class finds which directory on the stored Path supplies a given
+// executable, the way the command processor searches the Path. Rather than
+// searching the directories on every lookup, it lists each directory once and
+// indexes every file name found. The index is rebuilt when pathAdd or
+// pathRemove changes the Path. The stored Path and the modification times of
+// the directories are rechecked at most once per second, so files added or
+// removed later, and changes to the Path made by other means, are noticed
+// within a second. References to variables in the Path's entries (such as
+// %JAVA_HOME%\bin) are expanded with the stored variables, as they are for new
+// processes, and are expanded again at each check.
+//
+// The index also keeps a log of how many times each name has been looked up,
+// which can be used to reorder the Path so that frequently used directories
+// are searched first (see optimize). The log holds at most 4,096 names; when
+// it is full, every count is halved and the names whose count drops to zero
+// are forgotten, so the log favors recent lookups. The log can be saved to a
+// file and loaded again (see saveLog and loadLog), so that lookups made by
+// many processes over time can be combined.
+//
+// An index can also be built for a given Path value rather than a stored one
+// (for instance, a Path being prepared for another machine, or a test
+// fixture). Such a value is never re-read, but its directories are still
+// relisted when they change.
+//
+// On other systems, which have no stored Path, the process's PATH (with its
+// colons read as semicolons) stands in for the stored Path of every scope,
+// and references are expanded from the process's environment. Names are
+// matched with regard to case there, as the file system matches them, but
+// the extensions are still tried as the command processor tries them, so
+// that indexing and lookups can be measured there (see
+// envtest/benchWhich.cpp).
+//
+// Lookups are serialized, so one index can be shared by many threads.
+class editenv::PathIndex
+{
+public:
+    // Number of lookups of each name, keyed by name (lowercased on Windows).
+    typedef PathLookups Counts;
+
+    // Constructs an empty index for a scope's Path. The directories are listed
+    // on the first lookup.
+    //
+    // scope [in]    Environment scope (user or system path). Pass es_invalid
+    //               for the system path followed by the user path, which is the
+    //               Path that new processes receive.
+    explicit PathIndex (env_scope scope);
+
+    // Constructs an empty index for a given Path value. The directories are
+    // listed on the first lookup. References in the value's entries are
+    // expanded as they are for the stored Path.
+    //
+    // value [in]    Semicolon separated list of directories to index.
+    explicit PathIndex (std::string const &value);
+
+    // Destroys the index.
+    ~PathIndex ();
+
+    // Finds the first directory on the Path that contains the named file. The
+    // directories are searched in order, and within each directory the name
+    // itself is tried first (if it already has an extension) and then the name
+    // with each of the extensions appended.
+    //
+    // name [in]          Name of the executable, without a directory.
+    //
+    // extensions [in]    Semicolon separated list of extensions to try, such as
+    //                    ".com;.exe;.bat".
+    //
+    // path [out]         Receives the full path of the file found.
+    //
+    // Return Value: Returns true if the file was found.
+    bool find (std::string const &name,
+               std::string const &extensions,
+               std::string       &path);
+
+    // Adds the number of times each name has been looked up with find to the
+    // given counts.
+    //
+    // counts [in, out]    Lookup counts to add to.
+    //
+    // reset [in]          Clear the log once it has been added.
+    //
+    // Return Value: Nothing.
+    void lookups (Counts &counts, bool reset);
+
+    // Adds lookup counts to the log, as if the lookups had been made with
+    // find.
+    //
+    // counts [in]    Lookup counts to add.
+    //
+    // Return Value: Nothing.
+    void record (Counts const &counts);
+
+    // Computes a new order for the entries of one scope's part of the Path
+    // that minimizes the expected number of directories searched per lookup,
+    // given how often each name is looked up. Lookups are resolved against the
+    // whole indexed Path, and a directory is moved forward in proportion to how
+    // many lookups it satisfies; lookups satisfied by the other scope's part
+    // of the Path (or not at all) count for no directory. Whenever two
+    // directories both contain an executable with the same name (ignoring its
+    // extension), they are kept in the same relative order, so every lookup
+    // still finds the same file. The Path itself is not changed. The order is
+    // computed by pathOrder from the listings in the index.
+    //
+    // scope [in]         Environment scope whose part of the Path to reorder.
+    //                    For an index of the combined Path, the system entries
+    //                    are the ones that come first. For an index of a given
+    //                    Path value, the whole value is reordered, whatever
+    //                    the scope.
+    //
+    // counts [in]        Number of lookups of each name.
+    //
+    // extensions [in]    Semicolon separated list of extensions to try, such as
+    //                    ".com;.exe;.bat".
+    //
+    // value [out]        Receives the scope's reordered Path, with each entry
+    //                    exactly as it appears in the stored Path.
+    //
+    // probesBefore [out] Receives the expected number of directories searched
+    //                    on the whole indexed Path per lookup with the current
+    //                    order.
+    //
+    // probesAfter [out]  Receives the expected number of directories searched
+    //                    on the whole indexed Path per lookup with the new
+    //                    order.
+    //
+    // Return Value: Returns the number of entries whose position changed.
+    unsigned int optimize (env_scope          scope,
+                           Counts const      &counts,
+                           std::string const &extensions,
+                           std::string       &value,
+                           double            &probesBefore,
+                           double            &probesAfter);
+
+    // Adds the lookup counts saved in a log file to the given counts. The file
+    // holds one name per line, preceded by its count and a tab. Lines that
+    // can't be read are skipped.
+    //
+    // file [in]           Path of the log file.
+    //
+    // counts [in, out]    Lookup counts to add to.
+    //
+    // Return Value: Returns ERROR_SUCCESS, or the Win32 error code of the
+    //               operation that failed. On other systems, returns 0 or the
+    //               errno value of the operation that failed.
+    static long loadLog (std::string const &file, Counts &counts);
+
+    // Adds lookup counts to those saved in a log file, creating the file if
+    // necessary. The file is opened for exclusive access while it is updated,
+    // so processes saving to the same file at the same time wait for each
+    // other. The file is bounded the same way as the log held by an index.
+    //
+    // file [in]      Path of the log file.
+    //
+    // counts [in]    Lookup counts to add.
+    //
+    // Return Value: Returns ERROR_SUCCESS, or the Win32 error code of the
+    //               operation that failed. On other systems, returns 0 or the
+    //               errno value of the operation that failed.
+    static long saveLog (std::string const &file, Counts const &counts);
+
+    // Retrieves the extensions that the command processor tries, from the
+    // PATHEXT environment variable of the current process.
+    //
+    // Return Value: Returns a semicolon separated list of extensions.
+    static std::string defaultExtensions ();
+
+    // Invalidates every index, forcing the Path to be re-read and re-indexed
+    // on the next lookup. Called whenever the library changes the Path.
+    //
+    // Return Value: Nothing.
+    static void invalidate ();
+
+private:
+    // Private type that holds the listing of one directory on the Path.
+    struct Directory_
+    {
+        std::string              path;         // Expanded directory path.
+        unsigned long            modified;     // Last write time (low part).
+        unsigned long            modifiedHigh; // Last write time (high part).
+        std::vector<std::string> files;        // Case folded file names.
+    };
+
+    // Private type that maps a case folded file name to the positions on the
+    // Path of the directories containing it, in ascending order.
+    typedef PathFiles Index_;
+
+    // Indexes are owned by a single scope and cannot be copied.
+    PathIndex (PathIndex const &other);
+    PathIndex & operator = (PathIndex const &other);
+
+    // Private function that creates the lock that serializes lookups.
+    //
+    // Return Value: Nothing.
+    void initialize_ ();
+
+    // Private function that re-reads the Path (unless it was given) and relists
+    // any directories that have changed, if enough time has passed since the
+    // last check.
+    //
+    // force [in]    Check now, regardless of when the last check was made.
+    //
+    // Return Value: Nothing.
+    void refresh_ (bool force);
+
+    // Private function that determines which directory satisfies a lookup.
+    //
+    // name [in]          Name being looked up.
+    //
+    // extensions [in]    Extensions to try.
+    //
+    // file [out]         Receives the name of the file found.
+    //
+    // Return Value: Returns the position of the directory on the Path, or the
+    //               number of directories if none of them satisfies the lookup.
+    unsigned int resolve_ (std::string const              &name,
+                           std::vector<std::string> const &extensions,
+                           std::string                    &file) const;
+
+    // Private function that lists the files in a directory.
+    //
+    // directory [in, out]    The directory to list.
+    //
+    // Return Value: Nothing.
+    static void list_ (Directory_ &directory);
+
+    // Private function that rebuilds the file name index from the listings.
+    //
+    // Return Value: Nothing.
+    void rebuild_ ();
+
+    // Private Data:
+    unsigned long           checked_;     // Tick count of the last check.
+    std::vector<Directory_> directories_; // Listings, in Path order.
+    long                    generation_;  // Invalidation count at last check.
+    Index_                  index_;       // File name index.
+    void                   *lock_;        // Serializes lookups.
+    Counts                  lookups_;     // Number of lookups of each name.
+    env_scope               scope_;       // Scope of the indexed Path.
+    bool                    stored_;      // Whether the Path is re-read.
+    unsigned int            systemCount_; // Entries from the system Path.
+    std::string             value_;       // Path value that was indexed.
+};
+
+#endif // EDITENV_PATH_INDEX
\ No newline at end of file
@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  editenv - Path List Manipulation Functions
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <limits>
+
+#include "PathList.hpp"
+
+// Appends the specified path to the list. Only appends it if it is not already
+// in the list.
+bool editenv::pathListAdd (std::string &list, std::string const &path)
+{
+    size_t const sizeMax = std::numeric_limits<size_t>::max();
+
+    size_t length = path.length();
+    size_t pos;
+
+    pos = list.find(path, 0);
+    while (sizeMax != pos) {
+        if (((0 == pos) ||
+             (';' == list[pos - 1])) &&
+            ((pos + length == list.length()) ||
+             (';' == list[pos + length]))) {
+            // Found the path in the list already.
+            return false;
+        }
+        pos = list.find(path, pos + 1);
+    }
+
+    if (0 == list.length()) {
+        // Nothing is in the list yet.
+        list = path;
+    } else {
+        list += ";" + path;
+    }
+
+    return true;
+}
+
+// Removes all matching instances of the specified path from the list.
+unsigned int editenv::pathListRemove (std::string &list, std::string const &path)
+{
+    size_t const sizeMax = std::numeric_limits<size_t>::max();
+
+    unsigned int count = 0;
+    size_t       length = path.length();
+    size_t       pos;
+
+    pos = list.find(path);
+    while (sizeMax != pos) {
+        if (((0 == pos) ||
+             (';' == list[pos - 1])) &&
+            ((pos + length == list.length()) ||
+             (';' == list[pos + length]))) {
+            // Found a match in the list.
+            ++count;
+            if (0 == pos) {
+                // This is the first directory in the list, so there is no
+                // preceding semicolon to remove.
+                if (length == list.length()) {
+                    // There is no trailing semicolon, either because this is
+                    // the only directory in the list.
+                    list = "";
+                } else {
+                    // Instead of removing the preceding semicolon (which
+                    // isn't there), remove the following semicolon so that the
+                    // new list doesn't begin with a semicolon.
+                    list.replace(pos, length + 1, "");
+                }
+            } else {
+                // Remove the preceding semicolon along with the path string.
+                list.replace(pos - 1, length + 1, "");
+            }
+            pos = list.find(path, pos);
+        } else {
+            pos = list.find(path, pos + 1);
+        }
+    }
+
+    return count;
+}
+
+// Splits the list at each semicolon.
+void editenv::pathListSplit (std::string const        &list,
+                             std::vector<std::string> &paths)
+{
+    size_t const sizeMax = std::numeric_limits<size_t>::max();
+
+    size_t end;
+    size_t start = 0;
+
+    paths.clear();
+    while (start < list.length()) {
+        end = list.find(';', start);
+        if (sizeMax == end) {
+            end = list.length();
+        }
+        if (end > start) {
+            paths.push_back(list.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  editenv - Path List Manipulation Functions Header
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef EDITENV_PATH_LIST_HPP
+#define EDITENV_PATH_LIST_HPP
+
+#include <string>
+#include <vector>
+
+// These functions operate on semicolon separated lists of directories, such as
+// the value of the Path environment variable, without reading or writing the
+// environment. They implement pathAdd and pathRemove, and can be used to edit
+// a Path value that is stored somewhere other than the current environment.
+namespace editenv {
+    // Appends the specified path to a path list, unless the list already
+    // contains it.
+    //
+    // list [in, out]    The path list to edit.
+    //
+    // path [in]         Path to append to the list.
+    //
+    // Return Value: Returns true if the path was appended, or false if the list
+    //               already contained it.
+    bool pathListAdd (std::string &list, std::string const &path);
+
+    // Removes all matching instances of the specified path from a path list.
+    //
+    // list [in, out]    The path list to edit.
+    //
+    // path [in]         Path to remove from the list.
+    //
+    // Return Value: Returns the number of matching instances that were removed.
+    unsigned int pathListRemove (std::string &list, std::string const &path);
+
+    // Splits a path list into its individual paths. Empty entries (such as the
+    // one following a trailing semicolon) are skipped.
+    //
+    // list [in]     The path list to split.
+    //
+    // paths [out]   Receives the paths in the order they appear in the list.
+    //
+    // Return Value: Nothing.
+    void pathListSplit (std::string const &list, std::vector<std::string> &paths);
+}
+
+#endif // EDITENV_PATH_LIST_HPP
\ No newline at end of file
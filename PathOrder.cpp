@@ -0,0 +1,251 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  editenv - Path Ordering Functions
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <algorithm>
+#include <limits>
+
+#include "PathOrder.hpp"
+
+void editenv::pathCandidates (std::string const              &name,
+                              std::vector<std::string> const &extensions,
+                              std::vector<std::string>       &candidates)
+{
+    size_t const sizeMax = std::numeric_limits<size_t>::max();
+
+    candidates.clear();
+    if (sizeMax != name.find('.')) {
+        candidates.push_back(name);
+    }
+    for (size_t i = 0; i < extensions.size(); ++i) {
+        candidates.push_back(name + extensions[i]);
+    }
+}
+
+unsigned int editenv::pathResolve (PathFiles const                &files,
+                                   unsigned int                    count,
+                                   std::vector<std::string> const &candidates,
+                                   size_t                         &candidate)
+{
+    unsigned int              best = count;
+    PathFiles::const_iterator found;
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        found = files.find(candidates[i]);
+        if ((files.end() != found) && (found->second.front() < best)) {
+            best = found->second.front();
+            candidate = i;
+        }
+    }
+
+    return best;
+}
+
+unsigned int editenv::pathOrder (PathFiles const                &files,
+                                 unsigned int                    count,
+                                 unsigned int                    first,
+                                 unsigned int                    last,
+                                 PathLookups const              &lookups,
+                                 std::vector<std::string> const &extensions,
+                                 std::vector<unsigned int>      &order,
+                                 double                         &probesBefore,
+                                 double                         &probesAfter)
+{
+    size_t const sizeMax = std::numeric_limits<size_t>::max();
+
+    std::vector<std::vector<bool> > ancestors;
+    unsigned int                    best;
+    double                          bestDensity;
+    size_t                          candidate;
+    std::vector<std::string>        candidates;
+    double                          density;
+    unsigned int                    found;
+    PathFiles                       groups;
+    size_t                          lookup;
+    unsigned int const              m = last - first;
+    unsigned int                    moved = 0;
+    unsigned int const              n = count;
+    std::vector<bool>               placed;
+    std::vector<unsigned int>       position;
+    std::vector<unsigned int>       resolved;
+    std::vector<unsigned int>       scheduled;
+    unsigned int                    setSize;
+    double                          setWeight;
+    double                          total = 0;
+    std::vector<double>             weights;
+
+    probesBefore = 0;
+    probesAfter = 0;
+
+    // Weigh each directory by the number of lookups it satisfies. Lookups are
+    // resolved against the whole Path, so a lookup satisfied before the range
+    // is reached counts for none of its directories.
+    weights.assign(m, 0);
+    for (PathLookups::const_iterator i = lookups.begin();
+         lookups.end() != i;
+         ++i) {
+        pathCandidates(i->first, extensions, candidates);
+        found = pathResolve(files, n, candidates, candidate);
+        resolved.push_back(found);
+        total += i->second;
+        if ((found >= first) && (found < last)) {
+            weights[found - first] += i->second;
+        }
+    }
+
+    // Group the range's directories by the executables they contain, ignoring
+    // extensions. Directories in the same group must keep their order, since
+    // the first of them is the one that satisfies lookups of that name.
+    // Directories outside the range don't move, so they can be left out.
+    for (PathFiles::const_iterator i = files.begin(); files.end() != i; ++i) {
+        std::vector<unsigned int> members;
+
+        for (size_t j = 0; j < i->second.size(); ++j) {
+            if ((i->second[j] >= first) && (i->second[j] < last)) {
+                members.push_back(i->second[j] - first);
+            }
+        }
+        if (members.empty()) {
+            continue;
+        }
+        for (size_t j = 0; j < extensions.size(); ++j) {
+            size_t const length = extensions[j].length();
+
+            if ((i->first.length() > length) &&
+                (0 == i->first.compare(i->first.length() - length,
+                                       length,
+                                       extensions[j]))) {
+                std::vector<unsigned int> &group =
+                    groups[i->first.substr(0, i->first.length() - length)];
+
+                group.insert(group.end(), members.begin(), members.end());
+            }
+        }
+        if ((sizeMax != i->first.find('.')) &&
+            (lookups.end() != lookups.find(i->first))) {
+            std::vector<unsigned int> &group = groups[i->first];
+
+            group.insert(group.end(), members.begin(), members.end());
+        }
+    }
+
+    // Every directory must stay after the directories that precede it in any
+    // of its groups. Since directories only ever have to follow directories
+    // that come before them on the Path, visiting them in Path order collects
+    // all of their ancestors.
+    ancestors.assign(m, std::vector<bool>(m, false));
+    for (PathFiles::iterator i = groups.begin(); groups.end() != i; ++i) {
+        std::vector<unsigned int> &group = i->second;
+
+        std::sort(group.begin(), group.end());
+        for (size_t j = 1; j < group.size(); ++j) {
+            if (group[j - 1] != group[j]) {
+                ancestors[group[j]][group[j - 1]] = true;
+            }
+        }
+    }
+    for (unsigned int i = 0; i < m; ++i) {
+        for (unsigned int j = 0; j < i; ++j) {
+            if (ancestors[i][j]) {
+                for (unsigned int k = 0; k < j; ++k) {
+                    if (ancestors[j][k]) {
+                        ancestors[i][k] = true;
+                    }
+                }
+            }
+        }
+    }
+
+    // Repeatedly pick the directory that, together with the directories that
+    // must come before it, satisfies the most lookups per directory searched,
+    // and place that set next (in its original order). Directories that
+    // satisfy no lookups are left at the end in their original order.
+    placed.assign(m, false);
+    while (scheduled.size() < m) {
+        best = m;
+        bestDensity = -1;
+        for (unsigned int i = 0; i < m; ++i) {
+            if (placed[i]) {
+                continue;
+            }
+            setWeight = weights[i];
+            setSize = 1;
+            for (unsigned int j = 0; j < i; ++j) {
+                if (ancestors[i][j] && !placed[j]) {
+                    setWeight += weights[j];
+                    ++setSize;
+                }
+            }
+            density = setWeight / setSize;
+            if (density > bestDensity) {
+                best = i;
+                bestDensity = density;
+            }
+        }
+        for (unsigned int j = 0; j < best; ++j) {
+            if (ancestors[best][j] && !placed[j]) {
+                placed[j] = true;
+                scheduled.push_back(j);
+            }
+        }
+        placed[best] = true;
+        scheduled.push_back(best);
+    }
+
+    // Work out the order of the whole Path, where each directory ends up, and
+    // the expected number of directories searched on the whole Path before
+    // and after. Lookups that no directory satisfies search all of them
+    // either way.
+    order.resize(n);
+    position.resize(n);
+    for (unsigned int i = 0; i < n; ++i) {
+        order[i] = i;
+        position[i] = i;
+    }
+    for (unsigned int i = 0; i < m; ++i) {
+        order[first + i] = first + scheduled[i];
+        position[first + scheduled[i]] = first + i;
+        if (scheduled[i] != i) {
+            ++moved;
+        }
+    }
+    lookup = 0;
+    for (PathLookups::const_iterator i = lookups.begin();
+         lookups.end() != i;
+         ++i, ++lookup) {
+        found = resolved[lookup];
+        if (found < n) {
+            probesBefore += (found + 1.0) * i->second;
+            probesAfter += (position[found] + 1.0) * i->second;
+        } else {
+            probesBefore += static_cast<double>(n) * i->second;
+            probesAfter += static_cast<double>(n) * i->second;
+        }
+    }
+    if (0 != total) {
+        probesBefore /= total;
+        probesAfter /= total;
+    }
+
+    return moved;
+}
\ No newline at end of file
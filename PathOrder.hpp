@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  editenv - Path Ordering Functions
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef EDITENV_PATH_ORDER_HPP
+#define EDITENV_PATH_ORDER_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+// These functions work out which directory on a Path satisfies a lookup, and
+// how to reorder a Path so that lookups search fewer directories, from the
+// names of the files in each directory. They don't list directories or read
+// the environment, so that they can be run on any Path data (see PathIndex,
+// which supplies them with the listings of the stored Path, and
+// envtest/benchOptimize.cpp, which simulates made up Paths). Names must be
+// case folded by the caller, the way the file system compares them.
+namespace editenv {
+    // Maps a file name to the positions on a Path of the directories
+    // containing it, in ascending order.
+    typedef std::map<std::string, std::vector<unsigned int> > PathFiles;
+
+    // Number of lookups of each name.
+    typedef std::map<std::string, unsigned long> PathLookups;
+
+    // Builds the names tried when looking a name up, in the order they are
+    // tried: the name itself (if it already has an extension), and then the
+    // name with each of the extensions appended.
+    //
+    // name [in]           Name being looked up.
+    //
+    // extensions [in]     Extensions to try, such as ".com" and ".exe".
+    //
+    // candidates [out]    Receives the names to try.
+    //
+    // Return Value: Nothing.
+    void pathCandidates (std::string const              &name,
+                         std::vector<std::string> const &extensions,
+                         std::vector<std::string>       &candidates);
+
+    // Determines which directory on a Path satisfies a lookup. The first
+    // directory containing any of the candidates wins, and within that
+    // directory the earliest candidate wins.
+    //
+    // files [in]             Names of the files in the Path's directories.
+    //
+    // count [in]             Number of directories on the Path.
+    //
+    // candidates [in]        Names to try (see pathCandidates).
+    //
+    // candidate [out]        Receives the position among the candidates of
+    //                        the name found.
+    //
+    // Return Value: Returns the position of the directory on the Path, or
+    //               count if none of them satisfies the lookup.
+    unsigned int pathResolve (PathFiles const                &files,
+                              unsigned int                    count,
+                              std::vector<std::string> const &candidates,
+                              size_t                         &candidate);
+
+    // Computes a new order for a range of the directories on a Path that
+    // minimizes the expected number of directories searched per lookup, given
+    // how often each name is looked up. Lookups are resolved against the whole
+    // Path, and a directory is moved forward in proportion to how many
+    // lookups it satisfies; lookups satisfied outside the range (or not at
+    // all) count for no directory. Whenever two directories both contain an
+    // executable with the same name (ignoring its extension), they are kept in
+    // the same relative order, so every lookup still finds the same file. The
+    // directories outside the range stay where they are.
+    //
+    // files [in]             Names of the files in the Path's directories.
+    //
+    // count [in]             Number of directories on the Path.
+    //
+    // first [in]             Position of the first directory to reorder.
+    //
+    // last [in]              Position following the last directory to
+    //                        reorder.
+    //
+    // lookups [in]           Number of lookups of each name.
+    //
+    // extensions [in]        Extensions to try, such as ".com" and ".exe".
+    //
+    // order [out]            Receives the new order of the whole Path: the
+    //                        original position of the directory placed at
+    //                        each position.
+    //
+    // probesBefore [out]     Receives the expected number of directories
+    //                        searched on the whole Path per lookup with the
+    //                        current order.
+    //
+    // probesAfter [out]      Receives the expected number of directories
+    //                        searched on the whole Path per lookup with the
+    //                        new order.
+    //
+    // Return Value: Returns the number of directories whose position changed.
+    unsigned int pathOrder (PathFiles const                &files,
+                            unsigned int                    count,
+                            unsigned int                    first,
+                            unsigned int                    last,
+                            PathLookups const              &lookups,
+                            std::vector<std::string> const &extensions,
+                            std::vector<unsigned int>      &order,
+                            double                         &probesBefore,
+                            double                         &probesAfter);
+}
+
+#endif // EDITENV_PATH_ORDER_HPP
\ No newline at end of file
@@ -0,0 +1,177 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  editenv - Registry Environment Storage Backend Implementation
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <windows.h>
+
+#include "EnvSubscription.hpp"
+#include "RegistryBackend.hpp"
+
+using namespace editenv;
+
+// Global Constants
+static UINT const broadcastTimeout = 100; // in milliseconds
+
+// Registry location of each scope's environment variables.
+template <env_scope Scope>
+struct RegistryScope;
+
+template <>
+struct RegistryScope<es_system>
+{
+    static HKEY key ()
+    {
+        return HKEY_LOCAL_MACHINE;
+    }
+
+    static char const * subKeyName ()
+    {
+        return "System\\CurrentControlSet\\Control\\"
+               "Session Manager\\Environment";
+    }
+};
+
+template <>
+struct RegistryScope<es_user>
+{
+    static HKEY key ()
+    {
+        return HKEY_CURRENT_USER;
+    }
+
+    static char const * subKeyName ()
+    {
+        return "Environment";
+    }
+};
+
+template <env_scope Scope>
+bool RegistryBackend::read (std::string const &name, std::string &value)
+{
+    PBYTE data;
+    DWORD size;
+    LONG  status;
+    HKEY  subKey;
+
+    status = RegOpenKeyEx(RegistryScope<Scope>::key(),
+                          RegistryScope<Scope>::subKeyName(),
+                          0,
+                          KEY_QUERY_VALUE,
+                          &subKey);
+    if (ERROR_SUCCESS != status) {
+        return false;
+    }
+
+    status = RegQueryValueEx(subKey, name.c_str(), 0, NULL, NULL, &size);
+    while (ERROR_SUCCESS == status) {
+        // The stored string is normally, but not necessarily, null terminated.
+        data = new BYTE [size + 1];
+        status = RegQueryValueEx(subKey, name.c_str(), 0, NULL, data, &size);
+        if (ERROR_SUCCESS == status) {
+            data[size] = '\0';
+            value = reinterpret_cast<char const *>(data);
+            delete [] data;
+            break;
+        }
+        delete [] data;
+
+        // If another process lengthened the value after its size was queried,
+        // size now holds the new size, so try again.
+        if (ERROR_MORE_DATA == status) {
+            status = ERROR_SUCCESS;
+        }
+    }
+    RegCloseKey(subKey);
+
+    return ERROR_SUCCESS == status;
+}
+
+template <env_scope Scope>
+void RegistryBackend::write (std::string const &name, std::string const &value)
+{
+    HKEY subKey;
+
+    if (ERROR_SUCCESS != RegOpenKeyEx(RegistryScope<Scope>::key(),
+                                      RegistryScope<Scope>::subKeyName(),
+                                      0,
+                                      KEY_SET_VALUE,
+                                      &subKey)) {
+        return;
+    }
+    RegSetValueEx(subKey,
+                  name.c_str(),
+                  0,
+                  REG_EXPAND_SZ,
+                  reinterpret_cast<BYTE const *>(value.c_str()),
+                  static_cast<DWORD>(value.length() + 1));
+    RegCloseKey(subKey);
+}
+
+template <env_scope Scope>
+void RegistryBackend::remove (std::string const &name)
+{
+    HKEY subKey;
+
+    if (ERROR_SUCCESS != RegOpenKeyEx(RegistryScope<Scope>::key(),
+                                      RegistryScope<Scope>::subKeyName(),
+                                      0,
+                                      KEY_SET_VALUE,
+                                      &subKey)) {
+        return;
+    }
+    RegDeleteValue(subKey, name.c_str());
+    RegCloseKey(subKey);
+}
+
+template <env_scope Scope>
+void RegistryBackend::notify (std::string const &name)
+{
+    DWORD_PTR result;
+
+    // Notify subscribers of exactly which variable changed.
+    EnvSubscription::publish(Scope, name);
+
+    // Broadcast WM_SETTINGCHANGE for Explorer and other top-level windows that
+    // don't subscribe. Windows that are hung are skipped rather than waited on.
+    SendMessageTimeout(HWND_BROADCAST,
+                       WM_SETTINGCHANGE,
+                       NULL,
+                       reinterpret_cast<LPARAM>("Environment"),
+                       SMTO_NORMAL | SMTO_ABORTIFHUNG,
+                       broadcastTimeout,
+                       &result);
+}
+
+// Explicit instantiations for the supported scopes. These are exported from
+// the DLL along with the rest of the class.
+template bool RegistryBackend::read<es_system> (std::string const &,
+                                                std::string &);
+template bool RegistryBackend::read<es_user> (std::string const &,
+                                              std::string &);
+template void RegistryBackend::write<es_system> (std::string const &,
+                                                 std::string const &);
+template void RegistryBackend::write<es_user> (std::string const &,
+                                               std::string const &);
+template void RegistryBackend::remove<es_system> (std::string const &);
+template void RegistryBackend::remove<es_user> (std::string const &);
+template void RegistryBackend::notify<es_system> (std::string const &);
+template void RegistryBackend::notify<es_user> (std::string const &);
\ No newline at end of file
@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  editenv - Registry Environment Storage Backend Header
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef EDITENV_REGISTRY_BACKEND
+#define EDITENV_REGISTRY_BACKEND
+
+#include <string>
+
+#include "editenvTypes.hpp"
+
+// This class is the BasicEnvVar backend for the non-volatile environment
+// variables stored in the system registry. System variables live under
+// HKEY_LOCAL_MACHINE and user variables under HKEY_CURRENT_USER. Each member
+// function template is instantiated for es_system and es_user only.
+class editenv::RegistryBackend
+{
+public:
+    // Reads the named variable's value.
+    //
+    // name [in]     The environment variable's name.
+    //
+    // value [out]   Receives the variable's value.
+    //
+    // Return Value: Returns false if the variable does not exist.
+    template <env_scope Scope>
+    static bool read (std::string const &name, std::string &value);
+
+    // Writes the named variable's value, creating the variable if it does not
+    // yet exist.
+    //
+    // name [in]     The environment variable's name.
+    //
+    // value [in]    The value to write.
+    //
+    // Return Value: Nothing.
+    template <env_scope Scope>
+    static void write (std::string const &name, std::string const &value);
+
+    // Deletes the named variable.
+    //
+    // name [in]     The environment variable's name.
+    //
+    // Return Value: Nothing.
+    template <env_scope Scope>
+    static void remove (std::string const &name);
+
+    // Re-reads the named variable, applies an edit to its value and writes the
+    // result, so that the edit isn't made to a value that another process has
+    // since changed. The registry gives no way to keep other processes from
+    // writing the value in between, so this only keeps the window between the
+    // read and the write as short as possible. Edit is any class with a member
+    // function void apply (std::string &value).
+    //
+    // name [in]     The environment variable's name.
+    //
+    // edit [in]     The edit to apply.
+    //
+    // value [out]   Receives the new value.
+    //
+    // Return Value: Nothing.
+    template <env_scope Scope, class Edit>
+    static void update (std::string const &name,
+                        Edit              &edit,
+                        std::string       &value)
+    {
+        if (!read<Scope>(name, value)) {
+            value = "";
+        }
+        edit.apply(value);
+        write<Scope>(name, value);
+    }
+
+    // Publishes the change to subscribers (see EnvSubscription) and broadcasts
+    // a WM_SETTINGCHANGE message to notify that the environment has been
+    // changed.
+    //
+    // name [in]     The name of the environment variable that changed.
+    //
+    // Return Value: Nothing.
+    template <env_scope Scope>
+    static void notify (std::string const &name);
+};
+
+#endif // EDITENV_REGISTRY_BACKEND
\ No newline at end of file
@@ -21,12 +21,23 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-#include <limits>
+#include <cstring>
+#include <windows.h>
+
+#undef max // unbelievable
 
 #include "editenv.hpp"
+#include "HiveEditor.hpp"
+#include "PathIndex.hpp"
+#include "PathList.hpp"
 
 using namespace editenv;
 
+// Global Variables
+static PathIndex pathIndex(es_invalid);      // Index of the combined Path.
+static PathIndex systemPathIndex(es_system); // Index of the system Path.
+static PathIndex userPathIndex(es_user);     // Index of the user Path.
+
 // Cuts all matching instances of "text" from the named variable's value.
 unsigned int envCut (env_scope scope, char const *name, char const *text)
 {
@@ -72,31 +83,13 @@ char const * envValue (env_scope scope, char const *name)
 // it to the Path variable if it is not already in the Path.
 void pathAdd (env_scope scope, char const *path)
 {
-    size_t const sizeMax = std::numeric_limits<size_t>::max();
-
-    size_t      length = std::string(path).length();
-    size_t      pos;
     std::string value;
     EnvVar      var(scope, "Path");
 
     value = var.value();
-    pos = value.find(path, 0);
-    while (sizeMax != pos) {
-        if (((0 == pos) ||
-             (';' == value[pos - 1])) &&
-            ((pos + length == value.length()) ||
-             (';' == value[pos + length]))) {
-            // Found the path in the "Path" environment variable already.
-            return;
-        }
-        pos = value.find(path, pos + 1);
-    }
-
-    if (0 == var.value().length()) {
-        // Nothing is in the Path environment variable yet.
-        var.set(path);
-    } else {
-        var.paste(std::string(";") + path);
+    if (pathListAdd(value, path)) {
+        var.set(value);
+        PathIndex::invalidate();
     }
 }
 
@@ -104,48 +97,191 @@ void pathAdd (env_scope scope, char const *path)
 // environment variable.
 unsigned int pathRemove (env_scope scope, char const *path)
 {
-    size_t const sizeMax = std::numeric_limits<size_t>::max();
-
-    unsigned int count = 0;
-    size_t       length = std::string(path).length();
-    size_t       pos;
+    unsigned int count;
     std::string  value;
     EnvVar       var(scope, "Path");
 
     value = var.value();
-    pos = value.find(path);
-    while (sizeMax != pos) {
-        if (((0 == pos) ||
-             (';' == value[pos - 1])) &&
-            ((pos + length == value.length()) ||
-             (';' == value[pos + length]))) {
-            // Found a match in the path environment variable.
-            ++count;
-            if (0 == pos) {
-                // This is the first directory in the path, so there is no
-                // preceding semicolon to remove.
-                if (length == value.length()) {
-                    // There is no trailing semicolon, either because this is
-                    // the only directory in the path.
-                    value = "";
-                } else {
-                    // Instead of removing the preceding semicolon (which
-                    // isn't there), remove the following semicolon so that the
-                    // new path value doesn't begin with a semicolon.
-                    value.replace(pos, length + 1, "");
-                }
-            } else {
-                // Remove the preceding semicolon along with the path string.
-                value.replace(pos - 1, length + 1, "");
-            }
-            pos = value.find(path, pos);
-        } else {
-            pos = value.find(path, pos + 1);
-        }
-    }
+    count = pathListRemove(value, path);
 
     // Set the new path environment variable.
     var.set(value);
+    PathIndex::invalidate();
 
     return count;
+}
+
+// Finds the executable on the Path using the cached directory listings.
+unsigned int envWhich (env_scope    scope,
+                       char const  *name,
+                       char const  *extensions,
+                       char        *buffer,
+                       unsigned int size)
+{
+    std::string  extensionList;
+    PathIndex   *index;
+    std::string  path;
+
+    switch (scope) {
+    case es_system:
+        index = &systemPathIndex;
+        break;
+
+    case es_user:
+        index = &userPathIndex;
+        break;
+
+    default:
+        index = &pathIndex;
+        break;
+    }
+
+    if (NULL == extensions) {
+        extensionList = PathIndex::defaultExtensions();
+    } else {
+        extensionList = extensions;
+    }
+
+    if (!index->find(name, extensionList, path)) {
+        return 0;
+    }
+    if (path.length() >= size) {
+        return static_cast<unsigned int>(path.length() + 1);
+    }
+    memcpy(buffer, path.c_str(), path.length() + 1);
+
+    return static_cast<unsigned int>(path.length());
+}
+
+// Reorders the Path by how often its directories satisfy lookups.
+unsigned int pathOptimize (env_scope         scope,
+                           env_lookup const *lookups,
+                           unsigned int      lookupCount,
+                           char const       *extensions,
+                           double           *probesBefore,
+                           double           *probesAfter)
+{
+    double            after = 0;
+    double            before = 0;
+    PathIndex::Counts counts;
+    std::string       extensionList;
+    unsigned int      moved;
+    std::string       value;
+
+    if ((es_system != scope) && (es_user != scope)) {
+        return 0;
+    }
+
+    if (NULL == lookups) {
+        pathIndex.lookups(counts, false);
+        systemPathIndex.lookups(counts, false);
+        userPathIndex.lookups(counts, false);
+    } else {
+        for (unsigned int i = 0; i < lookupCount; ++i) {
+            counts[lookups[i].name] += lookups[i].count;
+        }
+    }
+
+    if (NULL == extensions) {
+        extensionList = PathIndex::defaultExtensions();
+    } else {
+        extensionList = extensions;
+    }
+
+    // New processes search the combined Path, so the scope's directories are
+    // weighed by the lookups they satisfy there.
+    moved = pathIndex.optimize(scope,
+                               counts,
+                               extensionList,
+                               value,
+                               before,
+                               after);
+    if (0 != moved) {
+        EnvVar var(scope, "Path");
+
+        var.set(value);
+        PathIndex::invalidate();
+    }
+
+    if (NULL != probesBefore) {
+        *probesBefore = before;
+    }
+    if (NULL != probesAfter) {
+        *probesAfter = after;
+    }
+
+    return moved;
+}
+
+// Adds the lookups made with envWhich by this process to a log file.
+long envWhichLogSave (char const *file)
+{
+    PathIndex::Counts counts;
+    long              status;
+
+    pathIndex.lookups(counts, true);
+    systemPathIndex.lookups(counts, true);
+    userPathIndex.lookups(counts, true);
+
+    status = PathIndex::saveLog(file, counts);
+    if (ERROR_SUCCESS != status) {
+        // Keep the lookups for the next attempt.
+        pathIndex.record(counts);
+    }
+
+    return status;
+}
+
+// Adds the lookups saved in a log file to this process's lookups.
+long envWhichLogLoad (char const *file)
+{
+    PathIndex::Counts counts;
+    long              status;
+
+    status = PathIndex::loadLog(file, counts);
+    if (ERROR_SUCCESS == status) {
+        pathIndex.record(counts);
+    }
+
+    return status;
+}
+
+// Applies the change set to each of the hive files.
+void hiveApply (char const * const *hives,
+                unsigned int        hiveCount,
+                env_edit const     *edits,
+                unsigned int        editCount,
+                long               *results)
+{
+    HiveEditor editor(edits, editCount);
+
+    editor.applyAll(hives, hiveCount, results);
+}
+
+// Subscribes to changes to the named variable (or all variables).
+EnvSubscription * envSubscribe (env_scope scope, char const *name)
+{
+    EnvSubscription *subscription;
+
+    subscription = new EnvSubscription(scope, (NULL == name) ? "" : name);
+    if (!subscription->subscribed()) {
+        delete subscription;
+        return NULL;
+    }
+
+    return subscription;
+}
+
+// Waits for the next change matching the subscription.
+int envWaitChange (EnvSubscription *subscription,
+                   env_change      *change,
+                   unsigned long    timeout)
+{
+    return subscription->wait(*change, timeout) ? 1 : 0;
+}
+
+// Cancels the subscription.
+void envUnsubscribe (EnvSubscription *subscription)
+{
+    delete subscription;
 }
\ No newline at end of file
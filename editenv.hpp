@@ -24,14 +24,20 @@
 #ifndef EDITENV_EDITENV_HPP
 #define EDITENV_EDITENV_HPP
 
-#ifdef EDITENV_BUILD
+#if !defined(_WIN32)
+#define EDITENV_API
+#elif defined(EDITENV_BUILD)
 #define EDITENV_API __declspec(dllexport)
 #else
 #define EDITENV_API __declspec(dllimport)
 #endif // EDITENV_BUILD
 
 #include "editenvTypes.hpp"
+#include "BasicEnvVar.hpp"
+#include "EnvSubscription.hpp"
 #include "EnvVar.hpp"
+#include "MemoryBackend.hpp"
+#include "RegistryBackend.hpp"
 
 #ifdef __cplusplus
 extern "C" {
@@ -119,6 +125,160 @@ EDITENV_API void pathAdd (editenv::env_scope, char const *path);
 // Return value: Returns the number of matching instances that were removed.
 EDITENV_API unsigned int pathRemove (editenv::env_scope, char const *path);
 
+// Finds which directory on the stored Path supplies the named executable, the
+// way the command processor searches the Path. The directories on the Path are
+// listed once and cached, so repeated lookups do not touch the file system.
+// The cache is refreshed when pathAdd or pathRemove changes the Path, and
+// otherwise the stored Path and the directories are rechecked at most once per
+// second.
+//
+// scope      [in]    Environment scope (user path or system path), or
+//                    es_invalid for the system path followed by the user path.
+//
+// name       [in]    Name of the executable, without a directory.
+//
+// extensions [in]    Semicolon separated list of extensions to try, such as
+//                    ".com;.exe;.bat", or NULL to use the PATHEXT variable.
+//
+// buffer     [out]   Receives the full path of the executable.
+//
+// size       [in]    Size of the buffer, in characters.
+//
+// Return Value: Returns the length of the full path, not including the
+//               terminating null character. If the buffer is too small, returns
+//               the size of the buffer required instead, including the null
+//               character. Returns 0 if the executable was not found.
+EDITENV_API unsigned int envWhich (editenv::env_scope  scope,
+                                   char const         *name,
+                                   char const         *extensions,
+                                   char               *buffer,
+                                   unsigned int        size);
+
+// Reorders the directories on a scope's Path so that the ones satisfying the
+// most lookups are searched first, reducing the number of directories searched
+// when processes are launched. Lookups are resolved the way new processes
+// resolve them, against the system Path followed by the user Path, so a
+// directory on the user Path is only credited with the lookups that aren't
+// satisfied by the system Path first. Whenever two directories both contain an
+// executable with the same name (with any of the extensions), their relative
+// order is kept, so every lookup still finds the same file. The new Path is
+// written with a single update.
+//
+// scope        [in]    Environment scope (user path or system path).
+//
+// lookups      [in]    How often each executable is looked up, or NULL to use
+//                      the lookups made with envWhich by this process (along
+//                      with any loaded with envWhichLogLoad).
+//
+// lookupCount  [in]    Number of entries in lookups.
+//
+// extensions   [in]    Semicolon separated list of extensions to try, such as
+//                      ".com;.exe;.bat", or NULL to use the PATHEXT variable.
+//
+// probesBefore [out]   If not NULL, receives the expected number of directories
+//                      searched per lookup with the original order, counting
+//                      the directories on both the system and user Paths.
+//
+// probesAfter  [out]   If not NULL, receives the expected number of directories
+//                      searched per lookup with the new order, counting the
+//                      directories on both the system and user Paths.
+//
+// Return Value: Returns the number of directories whose position changed.
+EDITENV_API unsigned int pathOptimize (editenv::env_scope        scope,
+                                       editenv::env_lookup const *lookups,
+                                       unsigned int               lookupCount,
+                                       char const                *extensions,
+                                       double                    *probesBefore,
+                                       double                    *probesAfter);
+
+// Adds the lookups made with envWhich by this process to those saved in a log
+// file, creating the file if necessary, and then clears them (unless saving
+// fails), so that saving again later doesn't count them twice. Processes that
+// save to the same file take turns. The file keeps at most 4,096 names; when
+// it is full, every count is halved and the names whose count drops to zero
+// are dropped.
+//
+// file [in]    Path of the log file.
+//
+// Return Value: Returns ERROR_SUCCESS, or the Win32 error code of the file
+//               operation that failed.
+EDITENV_API long envWhichLogSave (char const *file);
+
+// Adds the lookups saved in a log file to this process's lookups, so that
+// pathOptimize can reorder the Path using the lookups of every process that
+// saved to the file. A file that doesn't exist is treated as empty.
+//
+// file [in]    Path of the log file.
+//
+// Return Value: Returns ERROR_SUCCESS, or the Win32 error code of the file
+//               operation that failed.
+EDITENV_API long envWhichLogLoad (char const *file);
+
+// Applies a change set to the user environments stored in several registry
+// hive files (such as other users' NTUSER.DAT files) that are not currently
+// loaded. The hives are edited in parallel, and each hive is written and
+// flushed only once, no matter how many edits the change set contains.
+// Requires Windows Vista or later.
+//
+// hives     [in]    Paths of the hive files to edit.
+//
+// hiveCount [in]    Number of hive files.
+//
+// edits     [in]    The edits to make to each hive, in the order to make them.
+//
+// editCount [in]    Number of edits.
+//
+// results   [out]   Receives a result for each hive, in the same order as the
+//                   hives: ERROR_SUCCESS, ERROR_FILE_NOT_FOUND if the hive
+//                   doesn't exist (it is not created), or the Win32 error code
+//                   of the first registry operation that failed (for example,
+//                   because the hive is loaded by a logged on user).
+//
+// Return Value: Nothing.
+EDITENV_API void hiveApply (char const * const         *hives,
+                            unsigned int                hiveCount,
+                            editenv::env_edit const    *edits,
+                            unsigned int                editCount,
+                            long                       *results);
+
+// Subscribes to changes made to the stored environment. Unlike listening for
+// WM_SETTINGCHANGE, this works in processes without windows, wakes up only
+// when a matching variable changes, and reports which variable changed.
+//
+// scope [in]    Environment scope to watch (user or system environment), or
+//               es_invalid to watch both.
+//
+// name  [in]    Name of the variable to watch, or NULL to watch all variables.
+//
+// Return Value: Returns a subscription handle to be passed to envWaitChange
+//               and envUnsubscribe, or NULL if the subscription could not be
+//               registered.
+EDITENV_API editenv::EnvSubscription * envSubscribe (editenv::env_scope  scope,
+                                                     char const         *name);
+
+// Waits for the next change that matches a subscription.
+//
+// subscription [in]    Subscription handle returned by envSubscribe.
+//
+// change       [out]   Receives the scope, name and version of the change. If
+//                      the overflow member is nonzero, changes were missed and
+//                      all watched variables should be re-read.
+//
+// timeout      [in]    Maximum time to wait, in milliseconds.
+//
+// Return Value: Returns nonzero if a change was retrieved, or zero if the
+//               timeout elapsed first.
+EDITENV_API int envWaitChange (editenv::EnvSubscription *subscription,
+                               editenv::env_change      *change,
+                               unsigned long             timeout);
+
+// Cancels a subscription.
+//
+// subscription [in]    Subscription handle returned by envSubscribe.
+//
+// Return Value: Nothing.
+EDITENV_API void envUnsubscribe (editenv::EnvSubscription *subscription);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif // __cplusplus
@@ -24,7 +24,9 @@
 #ifndef EDITENV_EDITENV_TYPES_HPP
 #define EDITENV_EDITENV_TYPES_HPP
 
-#ifdef EDITENV_BUILD
+#if !defined(_WIN32)
+#define EDITENV_API
+#elif defined(EDITENV_BUILD)
 #define EDITENV_API __declspec(dllexport)
 #else
 #define EDITENV_API __declspec(dllimport)
@@ -38,7 +40,53 @@ namespace editenv {
         es_user     // Current user's environment variables
     };
 
+    // Possible operations in a change set (see hiveApply):
+    enum env_op {
+        eo_cut,         // Cut text from the variable's value (see envCut)
+        eo_paste,       // Append text to the variable's value (see envPaste)
+        eo_set,         // Assign text as the variable's value (see envSet)
+        eo_unset,       // Delete the variable (see envUnset)
+        eo_path_add,    // Append a directory to the variable (see pathAdd)
+        eo_path_remove  // Remove a directory from the variable (see pathRemove)
+    };
+
+    // Describes a single edit in a change set.
+    struct env_edit {
+        env_op      op;   // Operation to perform
+        char const *name; // Name of the variable to edit
+        char const *text; // Operand of the operation (ignored by eo_unset)
+    };
+
+    // Number of times an executable was looked up on the Path (see
+    // pathOptimize).
+    struct env_lookup {
+        char const    *name;  // Name of the executable, as passed to envWhich
+        unsigned long  count; // Number of lookups
+    };
+
+    // Maximum length of a variable name carried in a change notification,
+    // including the terminating null character. Longer names are truncated.
+    unsigned int const envNameMax = 256;
+
+    // Describes a change made to a stored environment variable, as delivered
+    // to subscribers (see EnvSubscription).
+    struct env_change {
+        env_scope     scope;              // Scope of the changed variable
+        unsigned long version;            // Sequence number of the change
+        int           overflow;           // Nonzero if changes were missed
+        char          name [envNameMax];  // Name of the changed variable
+    };
+
+    template <env_scope Scope, class Backend> class BasicEnvVar;
+    class MemoryBackend;
+    class EDITENV_API EnvFileBackend;
+    class EDITENV_API EnvFileBatch;
+    class EnvFileStore;
+    class EDITENV_API EnvSubscription;
     class EDITENV_API EnvVar;
+    class HiveEditor;
+    class PathIndex;
+    class EDITENV_API RegistryBackend;
 }
 
 #endif // EDITENV_EDITENV_TYPES_HPP
\ No newline at end of file
@@ -0,0 +1,182 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  envtest - Scope Dispatch Benchmark
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+#include <BasicEnvVar.hpp>
+#include <MemoryBackend.hpp>
+
+// This program measures what choosing the scope at run time costs per call.
+// It compares BasicEnvVar, whose scope and backend are fixed at compile time,
+// with a class that picks the backend operation for its scope on every call,
+// as EnvVar did before BasicEnvVar existed. Both use the in-memory backend, so
+// the registry's own cost doesn't swamp the difference.
+//
+// It is not part of the envtest project, and it does not need the editenv DLL.
+// Build it with optimization, e.g.:
+//
+//     cl /EHsc /O2 /I.. benchDispatch.cpp
+//     g++ -O2 -I.. benchDispatch.cpp -o benchDispatch
+
+using namespace editenv;
+
+// Global Constants
+static unsigned long const callCount  = 10000000;
+static unsigned int const  roundCount = 5; // the fastest round is reported
+
+// Edits a variable through MemoryBackend, choosing the operation for the scope
+// at run time.
+class RuntimeEnvVar
+{
+public:
+    RuntimeEnvVar (env_scope scope, std::string const &name)
+        : name_(name),
+          scope_(scope)
+    {
+        bool found = false;
+
+        switch (scope_) {
+        case es_system:
+            found = MemoryBackend::read<es_system>(name_, value_);
+            break;
+
+        case es_user:
+            found = MemoryBackend::read<es_user>(name_, value_);
+            break;
+
+        default:
+            break;
+        }
+        if (!found) {
+            value_ = "";
+        }
+    }
+
+    void set (std::string const &text)
+    {
+        value_ = text;
+
+        switch (scope_) {
+        case es_system:
+            MemoryBackend::write<es_system>(name_, value_);
+            MemoryBackend::notify<es_system>(name_);
+            break;
+
+        case es_user:
+            MemoryBackend::write<es_user>(name_, value_);
+            MemoryBackend::notify<es_user>(name_);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    std::string value () const
+    {
+        return value_;
+    }
+
+private:
+    std::string name_;
+    env_scope   scope_;
+    std::string value_;
+};
+
+// Retrieves the current time, in seconds.
+static double now ()
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    return static_cast<double>(counter.QuadPart) / frequency.QuadPart;
+#else
+    struct timeval time;
+
+    gettimeofday(&time, NULL);
+
+    return time.tv_sec + time.tv_usec / 1000000.0;
+#endif
+}
+
+// Sets a variable callCount times, alternating between two values, and
+// returns the average time per call in nanoseconds.
+template <class Var>
+static double timeCalls (Var &var, size_t &checksum)
+{
+    std::string const values [2] = { "C:\\Tools", "C:\\Bin" };
+
+    double start = now();
+
+    for (unsigned long i = 0; i < callCount; ++i) {
+        var.set(values[i & 1]);
+        checksum += var.value().length();
+    }
+
+    return (now() - start) * 1e9 / callCount;
+}
+
+int main (int argc, char *argv [])
+{
+    size_t checksum = 0;
+    double compileTime;
+    double runTime;
+
+    // Take the scope from the command line so that the compiler can't fold the
+    // run time dispatch away.
+    env_scope scope = (argc > 1) ? es_system : es_user;
+
+    BasicEnvVar<es_user, MemoryBackend> fixed("Path");
+    RuntimeEnvVar                       chosen(scope, "Path");
+
+    // Alternate between the two so that neither benefits from running later.
+    compileTime = timeCalls(fixed, checksum);
+    runTime = timeCalls(chosen, checksum);
+    for (unsigned int i = 1; i < roundCount; ++i) {
+        compileTime = std::min(compileTime, timeCalls(fixed, checksum));
+        runTime = std::min(runTime, timeCalls(chosen, checksum));
+    }
+
+    printf("%lu calls of set and value, best of %u (checksum %lu)\n",
+           callCount,
+           roundCount,
+           static_cast<unsigned long>(checksum));
+    printf("  scope fixed at compile time: %6.2f ns per call\n", compileTime);
+    printf("  scope chosen at run time:    %6.2f ns per call\n", runTime);
+    printf("  difference:                  %6.2f ns per call\n",
+           runTime - compileTime);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  envtest - Environment File Batch Benchmark
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <BasicEnvVar.hpp>
+#include <EnvFileBackend.hpp>
+
+// This program measures what batching saves when editing the environment.d
+// files. It times 1,000 sets of user variables (10 sets each to 100 variables)
+// made one at a time, each of which locks, reads, rewrites and syncs the files,
+// and the same 1,000 sets made within a single EnvFileBatch, which writes the
+// files once.
+//
+// The files are written to environment.d in a new temporary directory (set as
+// XDG_CONFIG_HOME), which is removed afterwards.
+//
+// It is not part of the envtest project, and only builds on POSIX systems.
+// Build it along with the environment file backend, e.g.:
+//
+//     g++ -O2 -I.. benchEnvFile.cpp ../EnvFileBackend.cpp -o benchEnvFile
+
+using namespace editenv;
+
+// Global Constants
+static unsigned int const setsPerVariable = 10;
+static unsigned int const variableCount   = 100;
+
+typedef BasicEnvVar<es_user, EnvFileBackend> UserVar;
+
+// Retrieves the current time, in seconds.
+static double now ()
+{
+    struct timeval time;
+
+    gettimeofday(&time, NULL);
+
+    return time.tv_sec + time.tv_usec / 1000000.0;
+}
+
+// Makes the sets, giving every variable a value that mentions the round.
+// Returns the time taken in milliseconds.
+static double setAll (std::vector<std::string> const &names, char const *round)
+{
+    double start = now();
+
+    for (unsigned int set = 0; set < setsPerVariable; ++set) {
+        for (size_t i = 0; i < names.size(); ++i) {
+            std::ostringstream value;
+
+            value << "/opt/" << round << "/" << set;
+            UserVar(names[i]).set(value.str());
+        }
+    }
+
+    return (now() - start) * 1000;
+}
+
+// Checks that every variable holds the value of the last set of a round.
+static bool check (std::vector<std::string> const &names, char const *round)
+{
+    std::ostringstream expected;
+    std::string        value;
+
+    expected << "/opt/" << round << "/" << setsPerVariable - 1;
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (!EnvFileBackend::read<es_user>(names[i], value) ||
+            (value != expected.str())) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main (int argc, char *argv [])
+{
+    char                     directory [] = "/tmp/benchEnvFile.XXXXXX";
+    double                   batched;
+    std::vector<std::string> names;
+    double                   unbatched;
+
+    if (NULL == mkdtemp(directory)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    setenv("XDG_CONFIG_HOME", directory, 1);
+
+    for (unsigned int i = 0; i < variableCount; ++i) {
+        std::ostringstream name;
+
+        name << "BENCH_" << i;
+        names.push_back(name.str());
+    }
+
+    unbatched = setAll(names, "unbatched");
+    if (!check(names, "unbatched")) {
+        fprintf(stderr, "unbatched sets were not all written\n");
+    }
+
+    // The batched time includes reading the files when the batch begins and
+    // writing them when it is committed.
+    {
+        double       start = now();
+        EnvFileBatch batch(es_user);
+
+        setAll(names, "batched");
+        if (!batch.commit()) {
+            fprintf(stderr, "batch commit failed\n");
+        }
+        batched = (now() - start) * 1000;
+    }
+    if (!check(names, "batched")) {
+        fprintf(stderr, "batched sets were not all written\n");
+    }
+
+    printf("%u sets of %u variables\n",
+           setsPerVariable * variableCount,
+           variableCount);
+    printf("  unbatched: %10.1f ms (%8.3f ms per set)\n",
+           unbatched,
+           unbatched / (setsPerVariable * variableCount));
+    printf("  batched:   %10.1f ms (%8.3f ms per set)\n",
+           batched,
+           batched / (setsPerVariable * variableCount));
+
+    // Clean up.
+    for (size_t i = 0; i < names.size(); ++i) {
+        UserVar(names[i]).unset();
+    }
+    unlink((std::string(directory) +
+            "/environment.d/50-editenv.conf").c_str());
+    unlink((std::string(directory) + "/environment.d/.editenv.lock").c_str());
+    rmdir((std::string(directory) + "/environment.d").c_str());
+    rmdir(directory);
+
+    return 0;
+}
\ No newline at end of file
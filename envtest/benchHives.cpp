@@ -0,0 +1,252 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  envtest - Offline Hive Editing Benchmark
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include <HiveEditor.hpp>
+
+// This program measures how applying a change set to offline hives scales with
+// the number of hives, from 1 to 1,000. For each count it creates that many
+// hives holding a 20 entry Path, then times applying a change set (one Path
+// entry added, one removed) to all of them one after another with
+// HiveEditor::apply, and in parallel with HiveEditor::applyAll.
+//
+// On Windows the hives are real registry hives, created by RegLoadAppKey. On
+// other systems they are HiveEditor's text file stand-ins. Either way they are
+// created empty in a new temporary directory, which is removed afterwards.
+//
+// It is not part of the envtest project. Build it along with the hive editor,
+// e.g.:
+//
+//     cl /EHsc /O2 /I.. benchHives.cpp ..\HiveEditor.cpp ..\PathList.cpp
+//        advapi32.lib
+//     g++ -O2 -I.. benchHives.cpp ../HiveEditor.cpp ../PathList.cpp -lpthread
+//         -o benchHives
+
+using namespace editenv;
+
+// Global Constants
+static unsigned int const hiveCounts []  = { 1, 10, 100, 1000 };
+static unsigned int const pathEntryCount = 20;
+#ifdef _WIN32
+static char const        *separator      = "\\";
+#else
+static char const        *separator      = "/";
+#endif
+
+// Retrieves the current time, in seconds.
+static double now ()
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    return static_cast<double>(counter.QuadPart) / frequency.QuadPart;
+#else
+    struct timeval time;
+
+    gettimeofday(&time, NULL);
+
+    return time.tv_sec + time.tv_usec / 1000000.0;
+#endif
+}
+
+// Creates a new, empty temporary directory and returns its path.
+static std::string makeDirectory ()
+{
+#ifdef _WIN32
+    char               buffer [MAX_PATH];
+    std::ostringstream path;
+
+    GetTempPath(MAX_PATH, buffer);
+    path << buffer << "benchHives." << GetCurrentProcessId();
+    CreateDirectory(path.str().c_str(), NULL);
+
+    return path.str();
+#else
+    char path [] = "/tmp/benchHives.XXXXXX";
+
+    return (NULL == mkdtemp(path)) ? "/tmp" : path;
+#endif
+}
+
+// Creates a new, empty hive, since HiveEditor only edits hives that exist.
+static void createHive (std::string const &hive)
+{
+#ifdef _WIN32
+    HKEY root;
+
+    if (ERROR_SUCCESS ==
+            RegLoadAppKey(hive.c_str(), &root, KEY_ALL_ACCESS, 0, 0)) {
+        RegCloseKey(root);
+    }
+#else
+    int descriptor = open(hive.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+    if (-1 != descriptor) {
+        close(descriptor);
+    }
+#endif
+}
+
+// Deletes a hive, along with the transaction logs the registry keeps for it.
+static void removeHive (std::string const &hive)
+{
+#ifdef _WIN32
+    DeleteFile(hive.c_str());
+    DeleteFile((hive + ".LOG1").c_str());
+    DeleteFile((hive + ".LOG2").c_str());
+#else
+    unlink(hive.c_str());
+#endif
+}
+
+// Applies a change set to the hives, checking that every hive succeeded.
+// Returns the time taken in milliseconds.
+static double applyAll (HiveEditor const               &editor,
+                        std::vector<char const *> const &hives,
+                        bool                             parallel)
+{
+    unsigned int      failed = 0;
+    std::vector<long> results(hives.size(), -1);
+    double            start = now();
+
+    if (parallel) {
+        editor.applyAll(&hives[0],
+                        static_cast<unsigned int>(hives.size()),
+                        &results[0]);
+    } else {
+        for (size_t i = 0; i < hives.size(); ++i) {
+            results[i] = editor.apply(hives[i]);
+        }
+    }
+
+    double elapsed = (now() - start) * 1000;
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (0 != results[i]) {
+            ++failed;
+        }
+    }
+    if (0 != failed) {
+        fprintf(stderr, "%u of %lu hives failed (e.g. error %ld)\n",
+                failed,
+                static_cast<unsigned long>(results.size()),
+                results[0]);
+    }
+
+    return elapsed;
+}
+
+int main (int argc, char *argv [])
+{
+    std::string const directory = makeDirectory();
+
+    std::ostringstream path;
+
+    // Each hive starts out with a 20 entry Path that includes C:\Tools\Old.
+    for (unsigned int i = 0; i < pathEntryCount - 1; ++i) {
+        path << "C:\\Program Files\\Package" << i << "\\bin;";
+    }
+    path << "C:\\Tools\\Old";
+    std::string const seedPath = path.str();
+
+    env_edit const seedEdits [] = {
+        { eo_set, "Path", seedPath.c_str() },
+        { eo_set, "TEMP", "%USERPROFILE%\\AppData\\Local\\Temp" }
+    };
+
+    // The change sets swap C:\Tools\Old for C:\Tools\New and back, so that
+    // every timed run changes (and rewrites) every hive.
+    env_edit const forwardEdits [] = {
+        { eo_path_add, "Path", "C:\\Tools\\New" },
+        { eo_path_remove, "Path", "C:\\Tools\\Old" }
+    };
+    env_edit const backwardEdits [] = {
+        { eo_path_add, "Path", "C:\\Tools\\Old" },
+        { eo_path_remove, "Path", "C:\\Tools\\New" }
+    };
+
+    HiveEditor const seed(seedEdits, 2);
+    HiveEditor const forward(forwardEdits, 2);
+    HiveEditor const backward(backwardEdits, 2);
+
+    printf("%6s %16s %16s %16s\n",
+           "hives", "sequential (ms)", "parallel (ms)", "per hive (ms)");
+    for (size_t count = 0;
+         count < sizeof(hiveCounts) / sizeof(hiveCounts[0]);
+         ++count) {
+        std::vector<std::string>  names;
+        std::vector<char const *> hives;
+        double                    parallel;
+        double                    sequential;
+
+        for (unsigned int i = 0; i < hiveCounts[count]; ++i) {
+            std::ostringstream name;
+
+            name << directory << separator << "user" << i << ".dat";
+            names.push_back(name.str());
+        }
+        for (size_t i = 0; i < names.size(); ++i) {
+            createHive(names[i]);
+            hives.push_back(names[i].c_str());
+        }
+
+        applyAll(seed, hives, true);
+        sequential = applyAll(forward, hives, false);
+        parallel = applyAll(backward, hives, true);
+
+        printf("%6u %16.1f %16.1f %16.3f\n",
+               hiveCounts[count],
+               sequential,
+               parallel,
+               parallel / hiveCounts[count]);
+
+        for (size_t i = 0; i < names.size(); ++i) {
+            removeHive(names[i]);
+        }
+    }
+
+#ifdef _WIN32
+    RemoveDirectory(directory.c_str());
+#else
+    rmdir(directory.c_str());
+#endif
+
+    return 0;
+}
\ No newline at end of file
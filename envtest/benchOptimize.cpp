@@ -0,0 +1,249 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  envtest - Path Reordering Benchmark
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <PathOrder.hpp>
+
+// This program simulates reordering Paths by how they are used, with
+// pathOrder, on made up Paths of 50, 100 and 200 directories of 10
+// executables each. No directories are listed and the environment is neither
+// read nor changed. Every seventh directory also holds the first executable
+// of the directory after it, shadowing it, and must keep doing so.
+//
+// For each Path, 10,000 lookups are drawn in one of two ways:
+//
+//  - Reversed: a directory's popularity grows with its position on the
+//    Path, so the most used directories come last.
+//  - Scattered: popularity falls off as 1/rank (a Zipf distribution), with
+//    the ranks given to the directories in a shuffled order.
+//
+// The program prints how many directories moved, the expected number of
+// directories searched per lookup before and after, the time taken to
+// compute the order, and how many lookups would resolve to a different file
+// afterwards (which must be none).
+//
+// It is not part of the envtest project. Build it along with the ordering
+// functions, e.g.:
+//
+//     cl /EHsc /O2 /I.. benchOptimize.cpp ..\PathOrder.cpp
+//     g++ -O2 -I.. benchOptimize.cpp ../PathOrder.cpp -o benchOptimize
+
+using namespace editenv;
+
+// Global Constants
+static unsigned int const directoryCounts [] = { 50, 100, 200 };
+static unsigned int const fileCount          = 10; // executables per directory
+static unsigned int const lookupCount        = 10000;
+static unsigned int const shadowEvery        = 7;  // directories per shadow
+
+// Steps a linear congruential generator, returning its next value.
+static unsigned long next (unsigned long &random)
+{
+    random = random * 1103515245 + 12345;
+
+    return (random >> 8) & 0xffffff;
+}
+
+// Builds the name of an executable (without its extension).
+static std::string toolName (unsigned int directory, unsigned int file)
+{
+    std::ostringstream name;
+
+    name << "opt" << directory << "_" << file;
+
+    return name.str();
+}
+
+// Builds the index of a made up Path, in which directory d holds the
+// executables optd_0.exe to optd_9.exe, and every seventh directory also
+// holds the first executable of the next one.
+static void makeFiles (unsigned int count, PathFiles &files)
+{
+    files.clear();
+    for (unsigned int i = 0; i < count; ++i) {
+        for (unsigned int j = 0; j < fileCount; ++j) {
+            files[toolName(i, j) + ".exe"].push_back(i);
+        }
+        if ((0 == i % shadowEvery) && (i + 1 < count)) {
+            files[toolName(i + 1, 0) + ".exe"].push_back(i);
+        }
+    }
+}
+
+// Draws lookups of the executables, picking each directory in proportion to
+// its weight.
+static void makeLookups (std::vector<double> const &weights,
+                         unsigned long             &random,
+                         PathLookups               &lookups)
+{
+    double pick;
+    double total = 0;
+
+    lookups.clear();
+    for (size_t i = 0; i < weights.size(); ++i) {
+        total += weights[i];
+    }
+    for (unsigned int i = 0; i < lookupCount; ++i) {
+        size_t directory = 0;
+
+        pick = next(random) / 16777216.0 * total;
+        while ((directory + 1 < weights.size()) &&
+               (pick >= weights[directory])) {
+            pick -= weights[directory];
+            ++directory;
+        }
+        ++lookups[toolName(static_cast<unsigned int>(directory),
+                           next(random) % fileCount)];
+    }
+}
+
+// Reorders a made up Path for the given lookups and prints the results.
+static void run (char const                     *label,
+                 unsigned int                    count,
+                 PathFiles const                &files,
+                 PathLookups const              &lookups,
+                 std::vector<std::string> const &extensions)
+{
+    size_t                    after;
+    size_t                    before;
+    std::vector<std::string>  candidates;
+    clock_t                   end;
+    unsigned int              found;
+    unsigned int              mismatches = 0;
+    unsigned int              moved;
+    std::vector<unsigned int> order;
+    std::vector<unsigned int> position(count);
+    double                    probesAfter;
+    double                    probesBefore;
+    PathFiles                 reordered;
+    clock_t                   start;
+
+    start = clock();
+    moved = pathOrder(files,
+                      count,
+                      0,
+                      count,
+                      lookups,
+                      extensions,
+                      order,
+                      probesBefore,
+                      probesAfter);
+    end = clock();
+
+    // Check that every lookup still finds the same file in the same
+    // directory.
+    for (unsigned int i = 0; i < count; ++i) {
+        position[order[i]] = i;
+    }
+    for (PathFiles::const_iterator i = files.begin(); files.end() != i; ++i) {
+        std::vector<unsigned int> &positions = reordered[i->first];
+
+        for (size_t j = 0; j < i->second.size(); ++j) {
+            positions.push_back(position[i->second[j]]);
+        }
+        std::sort(positions.begin(), positions.end());
+    }
+    for (PathLookups::const_iterator i = lookups.begin();
+         lookups.end() != i;
+         ++i) {
+        pathCandidates(i->first, extensions, candidates);
+        found = pathResolve(files, count, candidates, before);
+        if ((found < count) &&
+            ((position[found] !=
+              pathResolve(reordered, count, candidates, after)) ||
+             (before != after))) {
+            ++mismatches;
+        }
+    }
+
+    printf("%7u  %-10s %6u %14.2f %13.2f %10.1f %11u\n",
+           count,
+           label,
+           moved,
+           probesBefore,
+           probesAfter,
+           (end - start) * 1000.0 / CLOCKS_PER_SEC,
+           mismatches);
+}
+
+int main (int argc, char *argv [])
+{
+    std::vector<std::string> extensions;
+    PathFiles                files;
+    PathLookups              lookups;
+    unsigned long            random = 12345;
+    std::vector<double>      weights;
+
+    extensions.push_back(".com");
+    extensions.push_back(".exe");
+    extensions.push_back(".bat");
+    extensions.push_back(".cmd");
+
+    printf("%7s  %-10s %6s %14s %13s %10s %11s\n",
+           "entries",
+           "lookups",
+           "moved",
+           "probes before",
+           "probes after",
+           "time (ms)",
+           "mismatches");
+    for (size_t i = 0;
+         i < sizeof(directoryCounts) / sizeof(directoryCounts[0]);
+         ++i) {
+        unsigned int const count = directoryCounts[i];
+
+        makeFiles(count, files);
+
+        // Directory d is picked in proportion to d + 1.
+        weights.clear();
+        for (unsigned int j = 0; j < count; ++j) {
+            weights.push_back(j + 1.0);
+        }
+        makeLookups(weights, random, lookups);
+        run("reversed", count, files, lookups, extensions);
+
+        // The directories are ranked in a shuffled order, and picked in
+        // proportion to 1 / rank.
+        std::vector<unsigned int> ranks;
+
+        for (unsigned int j = 0; j < count; ++j) {
+            ranks.push_back(j + 1);
+        }
+        for (unsigned int j = count - 1; j > 0; --j) {
+            std::swap(ranks[j], ranks[next(random) % (j + 1)]);
+        }
+        for (unsigned int j = 0; j < count; ++j) {
+            weights[j] = 1.0 / ranks[j];
+        }
+        makeLookups(weights, random, lookups);
+        run("scattered", count, files, lookups, extensions);
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,273 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  envtest - Change Subscription Benchmark
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <ctime>
+#include <pthread.h>
+#endif
+
+#include <EnvSubscription.hpp>
+
+// This program measures how quickly changes published through EnvSubscription
+// reach their subscribers. Each change is published, and timed until every
+// subscriber has received it, before the next one is published:
+//
+//  - Latency: a single subscriber thread receives 1,000 changes.
+//  - Fan-out: 100 subscriber threads, all watching the same variable, receive
+//    100 changes.
+//
+// Only the shared ring buffer is used; no stored variables are changed. It is
+// not part of the envtest project. Build it against the editenv DLL, or on
+// Linux along with the subscription code, e.g.:
+//
+//     cl /EHsc /O2 /I.. benchSubscribe.cpp ..\Release\editenv.lib
+//     g++ -O2 -I.. benchSubscribe.cpp ../EnvSubscription.cpp -lpthread -lrt
+//         -o benchSubscribe
+
+using namespace editenv;
+
+// Global Constants
+static unsigned long const waitTimeout  = 10000; // in milliseconds
+static char const         *variableName = "EDITENV_BENCH";
+
+// A flag that one thread raises and another waits for, which is lowered again
+// once the wait is over (as with an auto-reset event).
+class Signal
+{
+public:
+    Signal ()
+    {
+#ifdef _WIN32
+        event_ = CreateEvent(NULL, FALSE, FALSE, NULL);
+#else
+        pthread_mutex_init(&lock_, NULL);
+        pthread_cond_init(&raised_, NULL);
+        set_ = false;
+#endif
+    }
+
+    ~Signal ()
+    {
+#ifdef _WIN32
+        CloseHandle(event_);
+#else
+        pthread_cond_destroy(&raised_);
+        pthread_mutex_destroy(&lock_);
+#endif
+    }
+
+    void raise ()
+    {
+#ifdef _WIN32
+        SetEvent(event_);
+#else
+        pthread_mutex_lock(&lock_);
+        set_ = true;
+        pthread_cond_signal(&raised_);
+        pthread_mutex_unlock(&lock_);
+#endif
+    }
+
+    void wait ()
+    {
+#ifdef _WIN32
+        WaitForSingleObject(event_, INFINITE);
+#else
+        pthread_mutex_lock(&lock_);
+        while (!set_) {
+            pthread_cond_wait(&raised_, &lock_);
+        }
+        set_ = false;
+        pthread_mutex_unlock(&lock_);
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE          event_;
+#else
+    pthread_mutex_t lock_;
+    pthread_cond_t  raised_;
+    bool            set_;
+#endif
+};
+
+// State shared by the main thread and the subscriber threads.
+struct BenchState
+{
+    unsigned int  changes;  // Number of changes each subscriber waits for.
+    long volatile pending;  // Subscribers yet to receive the current change.
+    Signal        ready;    // Raised once every subscriber is registered.
+    Signal        received; // Raised when every subscriber has the change.
+    long volatile started;  // Subscribers registered so far.
+    unsigned int  subscribers;
+};
+
+// Atomically adds to a counter shared by the threads, returning the result.
+static long add (long volatile *counter, long amount)
+{
+#ifdef _WIN32
+    return InterlockedExchangeAdd(counter, amount) + amount;
+#else
+    return __sync_add_and_fetch(counter, amount);
+#endif
+}
+
+// Retrieves the current time, in microseconds.
+static double now ()
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    return counter.QuadPart * 1000000.0 / frequency.QuadPart;
+#else
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return time.tv_sec * 1000000.0 + time.tv_nsec / 1000.0;
+#endif
+}
+
+// Thread procedure for a subscriber. Registers, then receives the changes,
+// letting the main thread know once the last subscriber has each one.
+#ifdef _WIN32
+static DWORD WINAPI subscriber (LPVOID parameter)
+#else
+static void * subscriber (void *parameter)
+#endif
+{
+    env_change       change;
+    BenchState      *state = static_cast<BenchState *>(parameter);
+    EnvSubscription  subscription(es_user, variableName);
+
+    if (!subscription.subscribed()) {
+        fprintf(stderr, "subscription failed\n");
+    }
+    if (add(&state->started, 1) == static_cast<long>(state->subscribers)) {
+        state->ready.raise();
+    }
+    for (unsigned int i = 0; i < state->changes; ++i) {
+        if (!subscription.wait(change, waitTimeout)) {
+            fprintf(stderr, "change not received\n");
+        }
+        if (0 == add(&state->pending, -1)) {
+            state->received.raise();
+        }
+    }
+
+    return 0;
+}
+
+// Prints the mean, median, 99th percentile and maximum of a set of times.
+static void report (char const *label, std::vector<double> &times)
+{
+    double total = 0;
+
+    std::sort(times.begin(), times.end());
+    for (size_t i = 0; i < times.size(); ++i) {
+        total += times[i];
+    }
+    printf("%-28s mean %8.1f  median %8.1f  p99 %8.1f  max %8.1f us\n",
+           label,
+           total / times.size(),
+           times[times.size() / 2],
+           times[times.size() * 99 / 100],
+           times.back());
+}
+
+// Publishes changes to the given number of subscribers and reports how long
+// the publishing takes and how long each change takes to reach all of them.
+static void run (char const   *label,
+                 unsigned int  subscribers,
+                 unsigned int  changes)
+{
+    double              delivered;
+    std::vector<double> deliveryTimes;
+    double              published;
+    std::vector<double> publishTimes;
+    double              start;
+    BenchState          state;
+#ifdef _WIN32
+    std::vector<HANDLE> threads;
+#else
+    std::vector<pthread_t> threads(subscribers);
+#endif
+
+    state.changes = changes;
+    state.pending = 0;
+    state.started = 0;
+    state.subscribers = subscribers;
+
+    for (unsigned int i = 0; i < subscribers; ++i) {
+#ifdef _WIN32
+        threads.push_back(CreateThread(NULL, 0, subscriber, &state, 0, NULL));
+#else
+        pthread_create(&threads[i], NULL, subscriber, &state);
+#endif
+    }
+    state.ready.wait();
+
+    for (unsigned int i = 0; i < changes; ++i) {
+        state.pending = subscribers;
+        start = now();
+        EnvSubscription::publish(es_user, variableName);
+        published = now();
+        state.received.wait();
+        delivered = now();
+
+        publishTimes.push_back(published - start);
+        deliveryTimes.push_back(delivered - start);
+    }
+
+    for (size_t i = 0; i < threads.size(); ++i) {
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+
+    printf("%s (%u subscribers, %u changes)\n", label, subscribers, changes);
+    report("  publish", publishTimes);
+    report("  delivery to all", deliveryTimes);
+}
+
+int main (int argc, char *argv [])
+{
+    run("Latency", 1, 1000);
+    run("Fan-out", 100, 100);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,274 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  envtest - Path Lookup Benchmark
+//  Copyright (c) 2009 Dan Moulding
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+//  See COPYING.txt for the full terms of the GNU Lesser General Public License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cstdlib>
+#include <strings.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include <PathIndex.hpp>
+#include <PathList.hpp>
+
+// This program measures how long it takes to find which directory on a 200
+// entry Path supplies an executable, over 10,000 lookups:
+//
+//  - Walking the Path: every directory is probed for the name with each
+//    extension, as a launcher does without an index.
+//  - PathIndex (which envWhich uses): the directories are listed once and
+//    indexed. The first lookup, which builds the index, is reported
+//    separately.
+//
+// The fixture is 200 directories of 10 executables each, created in a new
+// temporary directory, which is removed afterwards. One in ten lookups is for
+// a name that isn't on the Path. The index is given the fixture's Path
+// directly, so the stored Path is neither read nor changed.
+//
+// It is not part of the envtest project. Build it along with the index, e.g.:
+//
+//     cl /EHsc /O2 /DEDITENV_BUILD /I.. benchWhich.cpp ..\PathIndex.cpp
+//        ..\PathList.cpp ..\PathOrder.cpp ..\EnvVar.cpp ..\RegistryBackend.cpp
+//        ..\EnvSubscription.cpp advapi32.lib user32.lib
+//     g++ -O2 -I.. benchWhich.cpp ../PathIndex.cpp ../PathList.cpp
+//         ../PathOrder.cpp -lpthread -o benchWhich
+
+using namespace editenv;
+
+// Global Constants
+static unsigned int const directoryCount = 200;
+static char const        *extensions     = ".com;.exe;.bat;.cmd";
+static unsigned int const fileCount      = 10; // executables per directory
+static unsigned int const lookupCount    = 10000;
+#ifdef _WIN32
+static char const        *separator      = "\\";
+#else
+static char const        *separator      = "/";
+#endif
+
+// Retrieves the current time, in seconds.
+static double now ()
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    return static_cast<double>(counter.QuadPart) / frequency.QuadPart;
+#else
+    struct timeval time;
+
+    gettimeofday(&time, NULL);
+
+    return time.tv_sec + time.tv_usec / 1000000.0;
+#endif
+}
+
+// Creates a new, empty temporary directory and returns its path.
+static std::string makeDirectory ()
+{
+#ifdef _WIN32
+    char               buffer [MAX_PATH];
+    std::ostringstream path;
+
+    GetTempPath(MAX_PATH, buffer);
+    path << buffer << "benchWhich." << GetCurrentProcessId();
+    CreateDirectory(path.str().c_str(), NULL);
+
+    return path.str();
+#else
+    char path [] = "/tmp/benchWhich.XXXXXX";
+
+    return (NULL == mkdtemp(path)) ? "/tmp" : path;
+#endif
+}
+
+// Determines whether a file exists.
+static bool exists (std::string const &path)
+{
+#ifdef _WIN32
+    return INVALID_FILE_ATTRIBUTES != GetFileAttributes(path.c_str());
+#else
+    struct stat status;
+
+    return 0 == stat(path.c_str(), &status);
+#endif
+}
+
+// Builds the name of an executable in the fixture (without its extension).
+static std::string toolName (unsigned int directory, unsigned int file)
+{
+    std::ostringstream name;
+
+    name << "tool" << directory << "_" << file;
+
+    return name.str();
+}
+
+// Finds an executable by probing every directory with every extension.
+static bool walkPath (std::vector<std::string> const &directories,
+                      std::vector<std::string> const &extensionList,
+                      std::string const              &name,
+                      std::string                    &path)
+{
+    for (size_t i = 0; i < directories.size(); ++i) {
+        for (size_t j = 0; j < extensionList.size(); ++j) {
+            std::string candidate = directories[i] + separator + name +
+                                    extensionList[j];
+
+            if (exists(candidate)) {
+                path = candidate;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+int main (int argc, char *argv [])
+{
+    std::vector<std::string> directories;
+    std::vector<std::string> extensionList;
+    double                   first = 0;
+    std::vector<std::string> found;
+    double                   indexed;
+    std::vector<std::string> names;
+    std::ostringstream       path;
+    std::string const        root = makeDirectory();
+    unsigned int             mismatches = 0;
+    unsigned long            random = 12345;
+    double                   start;
+    double                   walked;
+
+    // Create the fixture.
+    for (unsigned int i = 0; i < directoryCount; ++i) {
+        std::ostringstream directory;
+
+        directory << root << separator << "dir" << i;
+        directories.push_back(directory.str());
+#ifdef _WIN32
+        CreateDirectory(directory.str().c_str(), NULL);
+#else
+        mkdir(directory.str().c_str(), 0755);
+#endif
+        for (unsigned int j = 0; j < fileCount; ++j) {
+            std::ofstream file((directory.str() + separator + toolName(i, j) +
+                                ".exe").c_str());
+        }
+        path << ((0 == i) ? "" : ";") << directory.str();
+    }
+    pathListSplit(extensions, extensionList);
+
+    // Pick the names to look up.
+    for (unsigned int i = 0; i < lookupCount; ++i) {
+        random = random * 1103515245 + 12345;
+        if (0 == (random >> 16) % 10) {
+            names.push_back("missing" + toolName(i, 0));
+        } else {
+            names.push_back(toolName((random >> 8) % directoryCount,
+                                     (random >> 20) % fileCount));
+        }
+    }
+
+    // Walk the Path for each lookup.
+    start = now();
+    for (unsigned int i = 0; i < lookupCount; ++i) {
+        std::string result;
+
+        walkPath(directories, extensionList, names[i], result);
+        found.push_back(result);
+    }
+    walked = now() - start;
+
+    // Look each name up in an index of the fixture's Path.
+    PathIndex index(path.str());
+
+    start = now();
+    for (unsigned int i = 0; i < lookupCount; ++i) {
+        std::string result;
+
+        index.find(names[i], extensions, result);
+        if (0 == i) {
+            first = now() - start;
+        }
+#ifdef _WIN32
+        if (0 != lstrcmpiA(result.c_str(), found[i].c_str())) {
+#else
+        if (0 != strcasecmp(result.c_str(), found[i].c_str())) {
+#endif
+            ++mismatches;
+        }
+    }
+    indexed = now() - start;
+
+    printf("%u lookups on a %u entry Path\n", lookupCount, directoryCount);
+    printf("  walking the Path:  %9.1f ms (%7.2f us per lookup)\n",
+           walked * 1000,
+           walked * 1000000 / lookupCount);
+    printf("  PathIndex:         %9.1f ms (%7.2f us per lookup)\n",
+           indexed * 1000,
+           indexed * 1000000 / lookupCount);
+    printf("    first lookup:    %9.1f ms (builds the index)\n", first * 1000);
+    printf("    the rest:        %9.1f ms (%7.2f us per lookup)\n",
+           (indexed - first) * 1000,
+           (indexed - first) * 1000000 / (lookupCount - 1));
+    printf("  mismatched results: %u\n", mismatches);
+
+    // Remove the fixture.
+    for (unsigned int i = 0; i < directoryCount; ++i) {
+        for (unsigned int j = 0; j < fileCount; ++j) {
+            std::string const file = directories[i] + separator +
+                                     toolName(i, j) + ".exe";
+
+#ifdef _WIN32
+            DeleteFile(file.c_str());
+#else
+            unlink(file.c_str());
+#endif
+        }
+#ifdef _WIN32
+        RemoveDirectory(directories[i].c_str());
+#else
+        rmdir(directories[i].c_str());
+#endif
+    }
+#ifdef _WIN32
+    RemoveDirectory(root.c_str());
+#else
+    rmdir(root.c_str());
+#endif
+
+    return 0;
+}
\ No newline at end of file
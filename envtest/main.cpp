@@ -21,15 +21,405 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <cassert>
+#include <string>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstdio>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <BasicEnvVar.hpp>
+#include <MemoryBackend.hpp>
 #include <editenv.hpp>
 
+#ifndef _WIN32
+#include <EnvFileBackend.hpp>
+#include <HiveEditor.hpp>
+#include <PathIndex.hpp>
+#include <PathOrder.hpp>
+#endif
+
+using namespace editenv;
+
+// Exercises BasicEnvVar with the in-memory backend, which leaves the real
+// environment alone.
+static void testMemoryBackend ()
+{
+    typedef BasicEnvVar<es_system, MemoryBackend> SystemVar;
+    typedef BasicEnvVar<es_user, MemoryBackend>   UserVar;
+
+    unsigned int cut;
+
+    MemoryBackend::clear<es_system>();
+    MemoryBackend::clear<es_user>();
+
+    UserVar path("Path");
+    assert(path.value().empty());
+
+    path.set("C:\\Tools;C:\\Bin");
+    path.paste(";C:\\Tools");
+    cut = path.cut("C:\\Tools");
+    assert(2 == cut);
+    assert(";C:\\Bin;" == path.value());
+
+    // Names are case insensitive, and each scope has its own variables.
+    assert(";C:\\Bin;" == UserVar("PATH").value());
+    assert(SystemVar("Path").value().empty());
+
+    path.unset();
+    assert(UserVar("Path").value().empty());
+    assert(4 == MemoryBackend::notifications<es_user>());
+    assert(0 == MemoryBackend::notifications<es_system>());
+}
+
+#ifndef _WIN32
+// Reads a whole file into a string.
+static std::string readFile (std::string const &path)
+{
+    std::ifstream      file(path.c_str());
+    std::ostringstream contents;
+
+    contents << file.rdbuf();
+
+    return contents.str();
+}
+
+// Exercises the environment file backend on a user environment.d directory in
+// a new temporary directory, which is removed afterwards.
+static void testEnvFileBackend ()
+{
+    typedef BasicEnvVar<es_user, EnvFileBackend> UserVar;
+
+    char        home [] = "/tmp/envtest.XXXXXX";
+    char       *created = mkdtemp(home);
+    std::string directory;
+    std::string file;
+    std::string value;
+
+    assert(NULL != created);
+    setenv("XDG_CONFIG_HOME", home, 1);
+    directory = std::string(home) + "/environment.d";
+    file = directory + "/50-editenv.conf";
+
+    // References to other variables are kept as they are written, so that
+    // systemd still expands them.
+    UserVar("PATH").set("$HOME/bin:$PATH");
+    UserVar("JAVA_BIN").set("${JAVA_HOME}/bin");
+    UserVar("PRICE").set("$$5");
+    assert("PATH=\"$HOME/bin:$PATH\"\n"
+           "JAVA_BIN=\"${JAVA_HOME}/bin\"\n"
+           "PRICE=\"$$5\"\n" == readFile(file));
+
+    UserVar path("PATH");
+    assert("$HOME/bin:$PATH" == path.value());
+    path.paste(":/opt/bin");
+    assert(EnvFileBackend::read<es_user>("PATH", value));
+    assert("$HOME/bin:$PATH:/opt/bin" == value);
+    assert(EnvFileBackend::read<es_user>("JAVA_BIN", value));
+    assert("${JAVA_HOME}/bin" == value);
+    assert(EnvFileBackend::read<es_user>("PRICE", value));
+    assert("$$5" == value);
+
+    // Quotes and escapes are read the way systemd reads them.
+    UserVar("QUOTED").set("it's \"a\\b\" `c`");
+    assert(EnvFileBackend::read<es_user>("QUOTED", value));
+    assert("it's \"a\\b\" `c`" == value);
+
+    path.unset();
+    UserVar("JAVA_BIN").unset();
+    UserVar("PRICE").unset();
+    UserVar("QUOTED").unset();
+    assert(readFile(file).empty());
+
+    // A file that is a symbolic link is edited through the link.
+    std::string const link = directory + "/10-linked.conf";
+    std::string const target = std::string(home) + "/linked.conf";
+
+    {
+        std::ofstream linked(target.c_str());
+
+        linked << "EDITOR=vi\n";
+    }
+    assert(0 == symlink(target.c_str(), link.c_str()));
+    UserVar("EDITOR").set("nano");
+    assert("EDITOR=nano\n" == readFile(target));
+    assert(EnvFileBackend::read<es_user>("EDITOR", value));
+    assert("nano" == value);
+    {
+        struct stat status;
+
+        assert((0 == lstat(link.c_str(), &status)) && S_ISLNK(status.st_mode));
+    }
+
+    // Nothing is written if one of the files can't be read (here, because it
+    // is a directory), since it would be overwritten.
+    std::string const unreadable = directory + "/20-unreadable.conf";
+
+    assert(0 == mkdir(unreadable.c_str(), 0755));
+    {
+        EnvFileBatch batch(es_user);
+
+        UserVar("EDITOR").set("emacs");
+        assert(!batch.commit());
+    }
+    assert("EDITOR=nano\n" == readFile(target));
+    rmdir(unreadable.c_str());
+
+    // Nothing is written if the lock can't be taken (here, because the lock
+    // file is a directory).
+    std::string const lock = directory + "/.editenv.lock";
+
+    unlink(lock.c_str());
+    assert(0 == mkdir(lock.c_str(), 0755));
+    UserVar("EDITOR").set("emacs");
+    assert("EDITOR=nano\n" == readFile(target));
+    rmdir(lock.c_str());
+
+    unlink(link.c_str());
+    unlink(target.c_str());
+    unlink(file.c_str());
+    unlink(lock.c_str());
+    rmdir(directory.c_str());
+    rmdir(home);
+}
+
+// Exercises the hive editor on a stand-in hive in a new temporary directory,
+// which is removed afterwards.
+static void testHiveEditor ()
+{
+    char        directory [] = "/tmp/envtest.XXXXXX";
+    char       *created = mkdtemp(directory);
+    std::string hive;
+    std::string missing;
+
+    assert(NULL != created);
+    hive = std::string(directory) + "/user.dat";
+    missing = std::string(directory) + "/missing.dat";
+    {
+        std::ofstream file(hive.c_str());
+
+        file << "Path=C:\\Tools;C:\\Bin\n";
+    }
+
+    // Cutting nothing leaves the value as it is.
+    env_edit const edits [] = {
+        { eo_cut, "Path", "" },
+        { eo_cut, "Path", NULL },
+        { eo_path_add, "Path", "C:\\New" }
+    };
+    HiveEditor const editor(edits, 3);
+
+    assert(0 == editor.apply(hive.c_str()));
+    assert("Path=C:\\Tools;C:\\Bin;C:\\New\n" == readFile(hive));
+
+    // A hive that doesn't exist is an error, and is not created.
+    char const *hives [] = { hive.c_str(), missing.c_str() };
+    long        results [2];
+
+    editor.applyAll(hives, 2, results);
+    assert(0 == results[0]);
+    assert(ENOENT == results[1]);
+    assert(0 != access(missing.c_str(), F_OK));
+
+    unlink(hive.c_str());
+    rmdir(directory);
+}
+
+// Exercises a path index of a Path given to it, made of two directories in a
+// new temporary directory, which is removed afterwards.
+static void testPathIndex ()
+{
+    char               directory [] = "/tmp/envtest.XXXXXX";
+    char              *created = mkdtemp(directory);
+    PathIndex::Counts  counts;
+    std::string        first;
+    std::string        log;
+    std::string        path;
+    std::string        second;
+
+    assert(NULL != created);
+    first = std::string(directory) + "/first";
+    second = std::string(directory) + "/second";
+    log = std::string(directory) + "/lookups.log";
+    assert(0 == mkdir(first.c_str(), 0755));
+    assert(0 == mkdir(second.c_str(), 0755));
+    std::ofstream((first + "/tool.bat").c_str());
+    std::ofstream((second + "/tool.exe").c_str());
+    std::ofstream((second + "/other.exe").c_str());
+
+    // The first directory on the Path wins, whichever extension it has. Names
+    // are matched with regard to case, as the file system matches them.
+    PathIndex index(first + ";" + second);
+
+    assert(index.find("tool", ".exe;.bat", path));
+    assert(first + "/tool.bat" == path);
+    assert(!index.find("TOOL", ".exe;.bat", path));
+    assert(index.find("other", ".exe", path));
+    assert(second + "/other.exe" == path);
+    assert(!index.find("missing", ".exe", path));
+
+    // Lookups are logged, and survive a trip through a log file.
+    index.lookups(counts, true);
+    assert(1 == counts["tool"]);
+    assert(1 == counts["other"]);
+    assert(0 == PathIndex::saveLog(log, counts));
+    assert(0 == PathIndex::saveLog(log, counts));
+    counts.clear();
+    assert(0 == PathIndex::loadLog(log, counts));
+    assert(2 == counts["tool"]);
+    assert(2 == counts["TOOL"]);
+    assert(2 == counts["missing"]);
+
+    unlink(log.c_str());
+    unlink((first + "/tool.bat").c_str());
+    unlink((second + "/tool.exe").c_str());
+    unlink((second + "/other.exe").c_str());
+    rmdir(first.c_str());
+    rmdir(second.c_str());
+    rmdir(directory);
+}
+
+// Exercises reordering made up Paths in which many names are shadowed by
+// earlier directories, checking that every lookup still finds the same file
+// in the same directory afterwards.
+static void testPathOrder ()
+{
+    char const * const extensionNames [] = { ".com", ".exe", ".bat" };
+    unsigned int const count = 30;
+
+    size_t                    after;
+    size_t                    before;
+    std::vector<std::string>  candidates;
+    std::vector<std::string>  extensions(extensionNames, extensionNames + 3);
+    PathFiles                 files;
+    unsigned int              found;
+    PathLookups               lookups;
+    std::vector<unsigned int> order;
+    std::vector<unsigned int> position(count);
+    double                    probes;
+    double                    probesAfter;
+    double                    probesBefore;
+    unsigned long             random = 12345;
+    unsigned int              ranges [][2] = { { 0, count }, { 5, 20 } };
+    double                    total;
+
+    // Each directory holds a few of 40 tools, so most tools are in several
+    // directories, with different extensions. A tool is also looked up with
+    // an extension.
+    for (unsigned int i = 0; i < count; ++i) {
+        for (unsigned int j = 0; j < 4; ++j) {
+            std::ostringstream name;
+
+            random = random * 1103515245 + 12345;
+            name << "tool" << (random >> 16) % 40
+                 << extensionNames[(random >> 8) % 3];
+            if (files[name.str()].empty() || (files[name.str()].back() != i)) {
+                files[name.str()].push_back(i);
+            }
+        }
+    }
+    for (unsigned int i = 0; i < 45; ++i) {
+        std::ostringstream name;
+
+        random = random * 1103515245 + 12345;
+        name << "tool" << i;
+        lookups[name.str()] = 1 + (random >> 16) % 100;
+    }
+    lookups["tool7.bat"] = 500;
+
+    for (size_t range = 0; range < 2; ++range) {
+        unsigned int const first = ranges[range][0];
+        unsigned int const last = ranges[range][1];
+        PathFiles          reordered;
+
+        pathOrder(files,
+                  count,
+                  first,
+                  last,
+                  lookups,
+                  extensions,
+                  order,
+                  probesBefore,
+                  probesAfter);
+        assert(probesAfter < probesBefore);
+
+        // Only the range moves, and every directory is still there once.
+        assert(count == order.size());
+        for (unsigned int i = 0; i < count; ++i) {
+            assert((i >= first && i < last) || (order[i] == i));
+            position[order[i]] = i;
+        }
+        for (unsigned int i = 0; i < count; ++i) {
+            assert(order[position[i]] == i);
+        }
+
+        // Build the index of the reordered Path.
+        for (PathFiles::const_iterator i = files.begin();
+             files.end() != i;
+             ++i) {
+            std::vector<unsigned int> &positions = reordered[i->first];
+
+            for (size_t j = 0; j < i->second.size(); ++j) {
+                positions.push_back(position[i->second[j]]);
+            }
+            std::sort(positions.begin(), positions.end());
+        }
+
+        // Every lookup finds the same file in the same directory, and the
+        // expected number of directories searched is as reported.
+        probes = 0;
+        total = 0;
+        for (PathLookups::const_iterator i = lookups.begin();
+             lookups.end() != i;
+             ++i) {
+            pathCandidates(i->first, extensions, candidates);
+            found = pathResolve(files, count, candidates, before);
+            if (count == found) {
+                assert(count == pathResolve(reordered,
+                                            count,
+                                            candidates,
+                                            after));
+                probes += static_cast<double>(count) * i->second;
+            } else {
+                unsigned int const moved = pathResolve(reordered,
+                                                       count,
+                                                       candidates,
+                                                       after);
+
+                assert(position[found] == moved);
+                assert(before == after);
+                probes += (moved + 1.0) * i->second;
+            }
+            total += i->second;
+        }
+        assert(fabs(probes / total - probesAfter) < 1e-9);
+    }
+}
+#endif
+
 // This provides a skeleton program/project for testing the environment variable
 // editor DLL (editenv.dll). Modify this main function to suit your testing
 // needs.
+//
+// On other systems, only the tests that don't need the DLL are run. Build them
+// with, e.g.:
+//
+//     g++ -I.. main.cpp ../EnvFileBackend.cpp ../HiveEditor.cpp
+//         ../PathIndex.cpp ../PathList.cpp ../PathOrder.cpp -lpthread
+//         -o envtest
 int main (int argc, char *argv [])
 {
-    using namespace editenv;
+    testMemoryBackend();
 
+#ifdef _WIN32
     pathAdd(es_user, "%SystemRoot%\\Meh");
 
     pathAdd(es_system, "%SystemRoot%\\Foo");
@@ -37,6 +427,12 @@ int main (int argc, char *argv [])
     pathRemove(es_user, "%SystemRoot%\\Meh");
 
     pathRemove(es_system, "%SystemRoot%\\Foo");
+#else
+    testEnvFileBackend();
+    testHiveEditor();
+    testPathIndex();
+    testPathOrder();
+#endif
 
     return 0;
 }
\ No newline at end of file